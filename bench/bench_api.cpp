@@ -0,0 +1,168 @@
+#include "bocom_ipc.h"
+#include "benchmark/benchmark.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Payload size sweep of the public calls, 16 B to 8 MB: the small sizes show
+// the per-call cost (Time is ns/op), the large ones the copy bandwidth
+// (bytes_per_second).
+constexpr auto kMinPayload = 16;
+constexpr auto kMaxPayload = 8 << 20;
+constexpr auto kQueueSize = 4;
+
+static Context CreateBenchObject(benchmark::State &state, int objectSize)
+{
+    st_CHANNAL_INFO chnInfo = {(char *)"bench_channel", objectSize, 0, 0, 1};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    st_OBJECT_INFO objInfo = {(char *)"bench_object", objectSize, RwLock, 0, 0};
+    if (chnCtx == nullptr || BOCOM_ConstructObject(chnCtx, &objInfo) != Success)
+    {
+        state.SkipWithError("create channel/object failed");
+        return nullptr;
+    }
+    return chnCtx;
+}
+
+static void DestroyBenchObject(Context chnCtx, int objectSize)
+{
+    st_OBJECT_INFO objInfo = {(char *)"bench_object", objectSize, RwLock, 0, 0};
+    BOCOM_DestroyObject(chnCtx, &objInfo);
+}
+
+// BOCOM_Publish by name, flags 0 (try-lock), 1 (blocking) and 2 (blocking, then notify).
+static void BM_Publish(benchmark::State &state)
+{
+    const auto size = static_cast<int>(state.range(0));
+    const auto flags = static_cast<int>(state.range(1));
+    auto chnCtx = CreateBenchObject(state, size);
+    if (chnCtx == nullptr)
+    {
+        return;
+    }
+    auto value = std::vector<char>(size, 0x5a);
+
+    for (auto _ : state)
+    {
+        if (BOCOM_Publish(chnCtx, (char *)"bench_object", value.data(), size, flags) != Success)
+        {
+            state.SkipWithError("BOCOM_Publish failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+
+    DestroyBenchObject(chnCtx, size);
+}
+BENCHMARK(BM_Publish)->ArgsProduct({benchmark::CreateRange(kMinPayload, kMaxPayload, 16), {0, 1, 2}});
+
+// BOCOM_Retrieve by name. With flags 2 every retrieve waits for the next
+// publish, a publisher thread keeps publishing: this is the hand-off latency.
+static void BM_Retrieve(benchmark::State &state)
+{
+    const auto size = static_cast<int>(state.range(0));
+    const auto flags = static_cast<int>(state.range(1));
+    auto chnCtx = CreateBenchObject(state, size);
+    if (chnCtx == nullptr)
+    {
+        return;
+    }
+    auto value = std::vector<char>(size, 0x5a);
+    auto out = std::vector<char>(size, 0);
+    BOCOM_Publish(chnCtx, (char *)"bench_object", value.data(), size, 1);
+
+    std::atomic<bool> done(false);
+    std::thread publisher;
+    if (2 == flags)
+    {
+        publisher = std::thread([&] {
+            while (!done.load(std::memory_order_relaxed))
+            {
+                BOCOM_Publish(chnCtx, (char *)"bench_object", value.data(), size, 2);
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    for (auto _ : state)
+    {
+        if (BOCOM_Retrieve(chnCtx, (char *)"bench_object", out.data(), size, flags) != Success)
+        {
+            state.SkipWithError("BOCOM_Retrieve failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+
+    done.store(true, std::memory_order_relaxed);
+    if (publisher.joinable())
+    {
+        publisher.join();
+    }
+    DestroyBenchObject(chnCtx, size);
+}
+BENCHMARK(BM_Retrieve)->ArgsProduct({benchmark::CreateRange(kMinPayload, kMaxPayload, 16), {0, 1, 2}})->UseRealTime();
+
+// BOCOM_PublishQueue into a queue whose elements are exactly the payload size.
+static void BM_PublishQueueSize(benchmark::State &state)
+{
+    const auto size = static_cast<int>(state.range(0));
+    const auto queueMode = static_cast<QueueMode>(state.range(1));
+    st_QUEUE_INFO queueInfo = {(char *)"bench_queue", size, kQueueSize, queueMode, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    if (pubContext == nullptr)
+    {
+        state.SkipWithError("BOCOM_CreateQueue failed");
+        return;
+    }
+    const auto msg = std::vector<char>(size, 0x5a);
+
+    for (auto _ : state)
+    {
+        if (BOCOM_PublishQueue(pubContext, msg.data(), size) != Success)
+        {
+            state.SkipWithError("BOCOM_PublishQueue failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+
+    BOCOM_DestroyQueue(pubContext);
+}
+BENCHMARK(BM_PublishQueueSize)->ArgsProduct({benchmark::CreateRange(kMinPayload, kMaxPayload, 16), {Polling, Notify}});
+
+// BOCOM_PublishQueue then BOCOM_RetrieveQueue of that message, so that Notify
+// never sleeps. The retrieve cost is this minus BM_PublishQueueSize: pausing
+// the timer around the publish would cost more than a small retrieve.
+static void BM_PublishRetrieveQueueSize(benchmark::State &state)
+{
+    const auto size = static_cast<int>(state.range(0));
+    const auto queueMode = static_cast<QueueMode>(state.range(1));
+    st_QUEUE_INFO queueInfo = {(char *)"bench_queue", size, kQueueSize, queueMode, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    auto subContext = BOCOM_JoinQueue("bench_queue");
+    if (pubContext == nullptr || subContext == nullptr)
+    {
+        state.SkipWithError("create/join queue failed");
+        return;
+    }
+    const auto msg = std::vector<char>(size, 0x5a);
+    auto out = std::vector<char>(size, 0);
+    unsigned int outLen = 0;
+
+    for (auto _ : state)
+    {
+        if (BOCOM_PublishQueue(pubContext, msg.data(), size) != Success ||
+            BOCOM_RetrieveQueue(subContext, out.data(), &outLen) != Success)
+        {
+            state.SkipWithError("publish/retrieve failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+
+    BOCOM_QuitQueue(subContext);
+    BOCOM_DestroyQueue(pubContext);
+}
+BENCHMARK(BM_PublishRetrieveQueueSize)->ArgsProduct({benchmark::CreateRange(kMinPayload, kMaxPayload, 16), {Polling, Notify}});
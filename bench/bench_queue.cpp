@@ -0,0 +1,192 @@
+#include "bocom_ipc.h"
+#include "benchmark/benchmark.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Per-call overhead of the queue engine with small payloads, where the
+// control path (locking, lookups) dominates the payload copy.
+constexpr auto kBenchElementSize = 4096;
+//Kept shallow so the slots stay in cache
+constexpr auto kBenchQueueSize = 4;
+
+static void BM_PublishQueue(benchmark::State &state)
+{
+    const auto msgSize = static_cast<int>(state.range(0));
+    const auto queueMode = static_cast<QueueMode>(state.range(1));
+    st_QUEUE_INFO queueInfo = {(char *)"bench_queue", kBenchElementSize, kBenchQueueSize, queueMode, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    if (pubContext == nullptr)
+    {
+        state.SkipWithError("BOCOM_CreateQueue failed");
+        return;
+    }
+    const auto msg = std::vector<char>(msgSize, 0x5a);
+
+    for (auto _ : state)
+    {
+        if (BOCOM_PublishQueue(pubContext, msg.data(), msg.size()) != Success)
+        {
+            state.SkipWithError("BOCOM_PublishQueue failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * msgSize);
+    state.SetItemsProcessed(state.iterations());
+
+    BOCOM_DestroyQueue(pubContext);
+}
+BENCHMARK(BM_PublishQueue)->ArgsProduct({{16, 256, kBenchElementSize}, {Polling, Spsc, Mpmc}});
+
+static void BM_PublishRetrieveQueue(benchmark::State &state)
+{
+    const auto msgSize = static_cast<int>(state.range(0));
+    const auto queueMode = static_cast<QueueMode>(state.range(1));
+    st_QUEUE_INFO queueInfo = {(char *)"bench_queue", kBenchElementSize, kBenchQueueSize, queueMode, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    auto subContext = BOCOM_JoinQueue("bench_queue");
+    if (pubContext == nullptr || subContext == nullptr)
+    {
+        state.SkipWithError("create/join queue failed");
+        return;
+    }
+    const auto msg = std::vector<char>(msgSize, 0x5a);
+    auto out = std::vector<char>(kBenchElementSize, 0);
+    unsigned int outLen = 0;
+
+    for (auto _ : state)
+    {
+        if (BOCOM_PublishQueue(pubContext, msg.data(), msg.size()) != Success ||
+            BOCOM_RetrieveQueue(subContext, out.data(), &outLen) != Success)
+        {
+            state.SkipWithError("publish/retrieve failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * msgSize);
+
+    BOCOM_QuitQueue(subContext);
+    BOCOM_DestroyQueue(pubContext);
+}
+BENCHMARK(BM_PublishRetrieveQueue)->ArgsProduct({{16, 256, kBenchElementSize}, {Polling, Spsc, Mpmc}});
+
+// Small messages published in batches: one lock hold and one wakeup per batch.
+// Compare items_per_second against BM_PublishQueue/16.
+static void BM_PublishQueueBatch(benchmark::State &state)
+{
+    constexpr auto msgSize = 16;
+    const auto batchSize = static_cast<int>(state.range(0));
+    const auto queueMode = static_cast<QueueMode>(state.range(1));
+    st_QUEUE_INFO queueInfo = {(char *)"bench_queue", kBenchElementSize, kBenchQueueSize, queueMode, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    if (pubContext == nullptr)
+    {
+        state.SkipWithError("BOCOM_CreateQueue failed");
+        return;
+    }
+    auto msg = std::vector<char>(msgSize, 0x5a);
+    const auto msgs = std::vector<iovec>(batchSize, iovec{msg.data(), msg.size()});
+
+    for (auto _ : state)
+    {
+        if (BOCOM_PublishQueueBatch(pubContext, msgs.data(), batchSize) != Success)
+        {
+            state.SkipWithError("BOCOM_PublishQueueBatch failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+
+    BOCOM_DestroyQueue(pubContext);
+}
+BENCHMARK(BM_PublishQueueBatch)->ArgsProduct({{1, 16, 64}, {Polling, Notify, Spsc, Mpmc}});
+
+static void PinToCpu(unsigned int cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+// Round trip of a small message between two threads on different cores: the
+// partner echoes every ping back on a second queue. Each round trip moves the
+// cache lines both sides write, so this is what the queue header layout is for.
+// Falls back to a shared core (and yields) when the machine has a single CPU.
+static void BM_QueuePingPong(benchmark::State &state)
+{
+    const auto queueMode = static_cast<QueueMode>(state.range(0));
+    st_QUEUE_INFO pingInfo = {(char *)"bench_ping", 64, kBenchQueueSize, queueMode, 0, 0, 0, 0};
+    st_QUEUE_INFO pongInfo = {(char *)"bench_pong", 64, kBenchQueueSize, queueMode, 0, 0, 0, 0};
+    auto pingPub = BOCOM_CreateQueue(&pingInfo);
+    auto pongPub = BOCOM_CreateQueue(&pongInfo);
+    auto pingSub = BOCOM_JoinQueue("bench_ping");
+    auto pongSub = BOCOM_JoinQueue("bench_pong");
+    if (pingPub == nullptr || pongPub == nullptr || pingSub == nullptr || pongSub == nullptr)
+    {
+        state.SkipWithError("create/join queue failed");
+        return;
+    }
+
+    const auto cpuCount = std::thread::hardware_concurrency();
+    std::atomic<bool> done(false);
+    std::thread partner([&] {
+        if (cpuCount > 1)
+        {
+            PinToCpu(1);
+        }
+        char value[64];
+        unsigned int valueLength = 0;
+        while (!done.load(std::memory_order_relaxed))
+        {
+            if (BOCOM_RetrieveQueue(pingSub, value, &valueLength) == Success)
+            {
+                BOCOM_PublishQueue(pongPub, value, valueLength);
+            }
+            else if (cpuCount <= 1)
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    if (cpuCount > 1)
+    {
+        PinToCpu(0);
+    }
+
+    uint64_t sequence = 0;
+    char value[64];
+    unsigned int valueLength = 0;
+    for (auto _ : state)
+    {
+        sequence++;
+        if (BOCOM_PublishQueue(pingPub, &sequence, sizeof(sequence)) != Success)
+        {
+            state.SkipWithError("BOCOM_PublishQueue failed");
+            break;
+        }
+        while (BOCOM_RetrieveQueue(pongSub, value, &valueLength) != Success)
+        {
+            if (cpuCount <= 1)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+    done.store(true, std::memory_order_relaxed);
+    partner.join();
+    state.SetItemsProcessed(state.iterations());
+
+    BOCOM_QuitQueue(pingSub);
+    BOCOM_QuitQueue(pongSub);
+    BOCOM_DestroyQueue(pingPub);
+    BOCOM_DestroyQueue(pongPub);
+}
+// Notify is left out: its retrieve blocks, the partner could not be stopped.
+BENCHMARK(BM_QueuePingPong)->Arg(Polling)->Arg(Spsc)->Arg(Mpmc)->UseRealTime();
+
+BENCHMARK_MAIN();
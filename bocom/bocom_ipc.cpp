@@ -3,13 +3,29 @@
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/sharable_lock.hpp>
 #include <boost/interprocess/sync/interprocess_condition_any.hpp>
-#include <boost/interprocess/containers/deque.hpp>
-#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/managed_heap_memory.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <cstdlib> //std::system
 #include <cstddef>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <chrono>
 #include <utility>
 #include <iostream>
+#include <climits>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+#include <linux/mempolicy.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include "bocom_ipc.h"
 
 #define LOG(tag, msg)                                        \
@@ -19,37 +35,303 @@
     } while (false);
 
 #define BOCOM_PRIV_NAME_LEN 128
-constexpr auto BOCOM_PRIV_HOLD_SIZE = 2048;
+constexpr auto BOCOM_PRIV_SCRATCH_SIZE = 16384;     //heap segment the queue control objects are measured in
+constexpr auto BOCOM_PRIV_CACHE_LINE = 64;
+constexpr auto BOCOM_PRIV_RECORD_ALIGN = 16;        //messages of a byte ring queue start at this alignment
+constexpr auto BOCOM_PRIV_MAX_SLOTS = 16;
+constexpr auto BOCOM_PRIV_DEFAULT_SLOTS = 3;
+constexpr auto BOCOM_PRIV_MAX_READER_FDS = 16;
+constexpr auto BOCOM_PRIV_MAX_CONSUMERS = 64;
+constexpr auto BOCOM_PRIV_MAX_NUMA_NODES = 1024;
+
+//The ring queues keep their indexes as std::atomic in the segment, which is only valid across processes when lock-free
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "64-bit atomics must be lock-free to be shared between processes");
 
 using namespace boost::interprocess;
 
 using RwlockType = boost::interprocess::interprocess_upgradable_mutex;
 using CondPubType = boost::interprocess::interprocess_condition_any;
-using BcomMsgType = std::pair<int, managed_shared_memory::handle_t>;
 using QueSizeType = std::pair<uint32_t, uint32_t>;      //(maxQueueSize,maxElementSize)
+using DeadlineType = boost::posix_time::ptime;           //absolute universal time, as boost::interprocess expects it
 
-struct QueueContext
+//A reader that waits in its own event loop, see BOCOM_GetQueueFd. Publishers send a datagram
+//to the abstract unix socket "bocom-<pid>-<serial>" when the reader is armed
+struct ReaderFdType
 {
-    uint64_t index = 0UL;
-    managed_shared_memory *segment = nullptr;
+    std::atomic<uint32_t> state;    //0 free  1 being registered  2 registered
+    std::atomic<uint32_t> armed;    //1 once the reader found nothing, cleared by the publisher that signals it
+    uint32_t pid;
+    uint32_t serial;
+};
+
+struct ReaderFdTable
+{
+    ReaderFdTable() : registered(0)
+    {
+        for (auto &reader : readers)
+        {
+            reader.state.store(0, std::memory_order_relaxed);
+            reader.armed.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint32_t> registered;   //lets publishers skip the scan while nobody uses a descriptor
+    ReaderFdType readers[BOCOM_PRIV_MAX_READER_FDS];
+};
+
+//A process that joined a queue, so that BOCOM_InspectConsumers can tell how far behind it is.
+//Padded to a cache line: each consumer updates its own index
+struct ConsumerType
+{
+    std::atomic<uint32_t> state;    //0 free  1 taken
+    std::atomic<uint32_t> pid;      //0 until the taker sets it
+    std::atomic<uint64_t> index;    //next message it retrieves, 0 before the first one
+    char padding[BOCOM_PRIV_CACHE_LINE - 16];
+};
+static_assert(sizeof(ConsumerType) == BOCOM_PRIV_CACHE_LINE, "a consumer takes one cache line");
+
+struct ConsumerTable
+{
+    ConsumerTable()
+    {
+        for (auto &consumer : consumers)
+        {
+            consumer.state.store(0, std::memory_order_relaxed);
+            consumer.pid.store(0, std::memory_order_relaxed);
+            consumer.index.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ConsumerType consumers[BOCOM_PRIV_MAX_CONSUMERS];
+};
+
+//Counters of a queue or an object behind st_STATS_INFO. Relaxed atomics, each group of fields on its own cache lines
+struct alignas(BOCOM_PRIV_CACHE_LINE) StatsType
+{
+    explicit StatsType(int statsFlags = 0)
+        : publishes(0), busy(0), retrieves(0), dataLost(0), noData(0), lockTimes(0 != (statsFlags & StatsLockTimes)),
+          lockWaitNs(0), lockHoldNs(0)
+    {
+        for (uint32_t i = 0; i < BOCOM_STATS_BUCKETS; i++)
+        {
+            lockWait[i].store(0, std::memory_order_relaxed);
+            lockHold[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    //Publishers
+    std::atomic<uint64_t> publishes;
+    std::atomic<uint64_t> busy;
+
+    //Consumers
+    alignas(BOCOM_PRIV_CACHE_LINE) std::atomic<uint64_t> retrieves;
+    std::atomic<uint64_t> dataLost;
+    std::atomic<uint64_t> noData;
+
+    //Everyone taking the rwlock. lockTimes is only written by the creator
+    alignas(BOCOM_PRIV_CACHE_LINE) bool lockTimes;
+    std::atomic<uint64_t> lockWaitNs;
+    std::atomic<uint64_t> lockHoldNs;
+    std::atomic<uint64_t> lockWait[BOCOM_STATS_BUCKETS];
+    std::atomic<uint64_t> lockHold[BOCOM_STATS_BUCKETS];
+};
+
+//Latest objects only: which buffer is the newest and who reads which. Follows StatsType in the object allocation
+struct LatestType
+{
+    LatestType() : latest(0)
+    {
+        for (auto &pin : pins)
+        {
+            pin.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<uint32_t> latest;   //the newest complete buffer
+    std::atomic<uint32_t> pins[BOCOM_PRIV_MAX_SLOTS];   //readers copying each buffer
+};
+
+//Queues and SeqLock/Latest objects: publishers bump seq, waiting readers sleep on it as a futex word
+struct NotifyType
+{
+    NotifyType() : seq(0), waiters(0), timedReaders(0)
+    {
+    }
+
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> waiters;
+    std::atomic<uint32_t> timedReaders;     //Polling/Spsc/Mpmc queues: seq is only bumped while there are some
 };
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the futex word must be a plain 32-bit integer");
 
-typedef struct
+//Constructed under the object name: payload size and handle plus the publication state of its mode
+struct BcomMsgType
 {
-    managed_shared_memory::handle_t itemHandle;
-    uint32_t itemLength;
-    uint64_t itemIndex;
-} QueMsgType;
+    BcomMsgType(int size, managed_shared_memory::handle_t handle, managed_shared_memory::handle_t stats, ObjectMode mode,
+                uint32_t slotCount)
+        : size(size), handle(handle), stats(stats), mode(mode), seq(0), slotCount(slotCount), notify(), readers()
+    {
+    }
+
+    int size;
+    managed_shared_memory::handle_t handle;     //Latest: slotCount buffers of size bytes
+    managed_shared_memory::handle_t stats;      //in the same allocation, on the first cache line after the buffers
+    ObjectMode mode;
+    std::atomic<uint64_t> seq;      //SeqLock/Latest: odd while a publisher is copying
+    uint32_t slotCount;
+    NotifyType notify;              //SeqLock/Latest: bumped by publishes with flags 2
+    ReaderFdTable readers;          //signalled by publishes with flags 2
+};
 
-//Define an STL compatible allocator of ints that allocates from the managed_shared_memory.
-//This allocator will allow placing containers in the segment
-using ShmemAllocator = allocator<QueMsgType, managed_shared_memory::segment_manager>;
-//Alias a deque that uses the previous STL-like allocator so that allocates
-//its values from the segment
-using BcomDequeType = deque<QueMsgType, ShmemAllocator>;
+//Object names resolved once by BOCOM_OpenObject, so publish/retrieve skip the segment index
+struct ObjectContext
+{
+    managed_shared_memory *segment = nullptr;
+    RwlockType *rwlock = nullptr;
+    CondPubType *cond_pub = nullptr;
+    BcomMsgType *msg = nullptr;
+    StatsType *stats = nullptr;
+    LatestType *latest = nullptr;   //Latest objects only
+    void *data = nullptr;
+    int size = 0;
+    int guard = 0;              //held by BOCOM_AcquireObjectRead/Write: 0 none  1 read  2 write
+    int guardFlags = 0;
+    uint64_t guardSeq = 0;      //SeqLock/Latest: sequence at acquire time
+    uint32_t guardSlot = 0;     //Latest: buffer handed out
+    uint64_t guardTime = 0;     //RwLock: when the lock was taken
+    int readerFd = -1;          //BOCOM_GetObjectFd
+    int readerSlot = -1;
+};
 
 typedef managed_shared_memory::const_named_iterator const_named_it;
 
+//Named after the queue: its block, which starts with the queue header on a cache line boundary.
+//The slots follow the header, whose size is a multiple of the cache line
+struct QueueBlockType
+{
+    managed_shared_memory::handle_t allocation;     //as returned by the allocator
+    managed_shared_memory::handle_t header;
+};
+
+//Header of the lock-free ring queue modes. Each group of fields has its own cache lines: head is written
+//by the publishers, tail by the consumers and by a publisher when it drops the oldest message
+struct alignas(BOCOM_PRIV_CACHE_LINE) RingQueueType
+{
+    RingQueueType(uint32_t depth, uint32_t mask, uint32_t slotSize)
+        : depth(depth), mask(mask), slotSize(slotSize), head(0), tail(0), lost(0), pinned(0), notify()
+    {
+    }
+
+    //Read-only once created
+    uint32_t depth;         //maxQueueSize, the oldest message is dropped beyond it
+    uint32_t mask;          //slot count - 1, the slot count is a power of two
+    uint32_t slotSize;      //bytes per slot, RingSlotType included
+
+    alignas(BOCOM_PRIV_CACHE_LINE) std::atomic<uint64_t> head;
+
+    alignas(BOCOM_PRIV_CACHE_LINE) std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> lost;     //Mpmc: messages dropped and not yet reported to a consumer
+    std::atomic<uint64_t> pinned;   //Spsc: index + 1 of the slot the consumer reads in place, 0 if none
+
+    //Timed retrieves only
+    alignas(BOCOM_PRIV_CACHE_LINE) NotifyType notify;
+
+    StatsType stats;
+};
+
+//Header of the Polling/Notify queues, guarded by its rwlock. Each group of fields has its own cache lines.
+//All maxQueueSize buffers are carved out in CreateQueue: a message takes an unused buffer or, when none
+//is left, the buffer of the oldest message. The entries list the queued messages, message i at i & mask.
+//Byte layout (queueBytes): one ring of ringBytes bytes instead, messages are packed in it one after the other
+struct alignas(BOCOM_PRIV_CACHE_LINE) PoolQueueType
+{
+    PoolQueueType(uint32_t capacity, uint32_t mask, uint32_t bufferSize, uint32_t ringBytes)
+        : capacity(capacity), mask(mask), bufferSize(bufferSize), ringBytes(ringBytes), rwlock(), head(0), tail(0),
+          freeCount((0 == ringBytes) ? capacity : 0), usedBytes(0), writeOffset(0), notify()
+    {
+    }
+
+    //Read-only once created
+    uint32_t capacity;      //maxQueueSize buffers, byte layout: at most maxQueueSize messages
+    uint32_t mask;          //entry count - 1, the entry count is a power of two
+    uint32_t bufferSize;    //maxElementSize rounded up to a cache line, byte layout: 1, buffers are byte offsets
+    uint32_t ringBytes;     //byte layout only, 0 otherwise
+
+    //Taken by publishers and consumers alike
+    alignas(BOCOM_PRIV_CACHE_LINE) RwlockType rwlock;
+
+    //Written by the publishers, read by the consumers
+    alignas(BOCOM_PRIV_CACHE_LINE) uint64_t head;      //index of the next message
+    uint64_t tail;          //index of the oldest queued message
+    uint32_t freeCount;     //the first freeCount numbers of the free list are unused buffers
+    uint32_t usedBytes;     //byte layout: ring bytes taken by the queued messages, they end at writeOffset
+    uint32_t writeOffset;
+
+    //Notify, and timed retrieves of Polling queues
+    alignas(BOCOM_PRIV_CACHE_LINE) NotifyType notify;
+
+    StatsType stats;
+};
+
+struct PoolEntryType
+{
+    uint64_t index;     //message index, consumers find message i here as long as index == i
+    uint32_t length;
+    uint32_t buffer;
+    uint32_t span;      //byte layout: ring bytes taken, the padding and a skipped end of the ring included
+};
+
+//Every ring slot starts with this header, the payload follows it
+struct RingSlotType
+{
+    //Mpmc: index + 1 once the message at index is published, index + slot count once it is consumed
+    std::atomic<uint64_t> seq;
+    uint64_t length;
+};
+
+//Queue control structures resolved once in CreateQueue/JoinQueue, so the per-message path
+//does no segment index traversal
+struct QueueContext
+{
+    uint64_t index = 0UL;
+    managed_shared_memory *segment = nullptr;
+    std::string queueName;
+    QueueBlockType *block = nullptr;
+    PoolQueueType *pool = nullptr;       //Polling/Notify only
+    PoolEntryType *poolEntries = nullptr;
+    uint32_t *poolFree = nullptr;
+    char *poolBuffers = nullptr;
+    RwlockType *rwlock = nullptr;
+    NotifyType *notify = nullptr;
+    uint32_t maxQueueSize = 0;
+    uint32_t maxElementSize = 0;
+    QueueMode queueMode = Polling;
+    void *loan = nullptr;                //slot handed out by BOCOM_LoanQueueSlot
+    uint64_t loanPos = 0;
+    unsigned int loanSize = 0;
+    bool peeking = false;                //a message is pinned by BOCOM_PeekQueue
+    uint64_t peekToken = 0;
+    uint64_t peekTime = 0;               //Polling/Notify: when the lock kept by the peek was taken
+    RingQueueType *ring = nullptr;       //ring queue modes only
+    char *ringSlots = nullptr;
+    ReaderFdTable *readers = nullptr;
+    StatsType *stats = nullptr;
+    ConsumerTable *consumers = nullptr;
+    ConsumerType *consumer = nullptr;    //registered by the first retrieve, nullptr before it or when the table is full
+    bool retrieved = false;              //a retrieve or peek ran, the context took its consumer entry then
+    int readerFd = -1;                   //BOCOM_GetQueueFd
+    int readerSlot = -1;
+    bool timedReader = false;            //counted in notify->timedReaders by BOCOM_RetrieveQueueTimed
+};
+
+//A channel or queue attached by BOCOM_AttachInspect. The segment is mapped read-only: find does not lock it
+//and nothing is written, so inspecting cannot disturb the processes that use it
+struct InspectContext
+{
+    managed_shared_memory *segment = nullptr;
+    QueueContext *queue = nullptr;   //queue segments only
+};
+
 static void *AllocInShmem(managed_shared_memory *segment, int length)
 {
     managed_shared_memory::size_type free_memory = segment->get_free_memory();
@@ -68,14 +350,283 @@ static void *AllocInShmem(managed_shared_memory *segment, int length)
     return shptr;
 }
 
-static void *GetAddrInShmem(managed_shared_memory *segment, char *objName)
+//Bytes some named objects take in a segment. They are built in a scratch heap segment instead,
+//which uses the same allocator and index
+template <class Construct>
+static managed_shared_memory::size_type NamedObjectsSize(Construct construct)
+{
+    managed_heap_memory scratch(BOCOM_PRIV_SCRATCH_SIZE);
+    const managed_heap_memory::size_type scratchFree = scratch.get_free_memory();
+    construct(&scratch);
+    return scratchFree - scratch.get_free_memory();
+}
+
+//The mapping starts a few bytes before the managed area
+static char *SegmentMapping(managed_shared_memory *segment, size_t *length)
+{
+    const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t address = reinterpret_cast<uintptr_t>(segment->get_address());
+    *length = segment->get_size() + (address & (pageSize - 1));
+    return reinterpret_cast<char *>(address & ~(pageSize - 1));
+}
+
+//MemNumaBind/MemNumaInterleave, by the creator only: tmpfs keeps the policy for the segment itself,
+//not per mapping. The pages touched while building the segment are moved
+static void BindSegment(managed_shared_memory *segment, int flags, int numaNode)
 {
-    if (nullptr == segment->find<BcomMsgType>(objName).first)
+    if (0 == (flags & (MemNumaBind | MemNumaInterleave)))
+    {
+        return;
+    }
+
+    constexpr auto maskBits = 8 * sizeof(unsigned long);
+    unsigned long nodeMask[BOCOM_PRIV_MAX_NUMA_NODES / maskBits] = {};
+    int mode = MPOL_INTERLEAVE;
+    if (flags & MemNumaBind)
+    {
+        if (numaNode < 0 || numaNode >= BOCOM_PRIV_MAX_NUMA_NODES)
+        {
+            LOG("BOCOM_MemoryFlags", "numaNode is illegal !");
+            return;
+        }
+        nodeMask[numaNode / maskBits] = 1UL << (numaNode % maskBits);
+        mode = MPOL_BIND;
+    }
+    else if (0 != syscall(SYS_get_mempolicy, nullptr, nodeMask, BOCOM_PRIV_MAX_NUMA_NODES, nullptr, MPOL_F_MEMS_ALLOWED))
+    {
+        LOG("BOCOM_MemoryFlags", "cannot get the allowed NUMA nodes !");
+        return;
+    }
+
+    size_t length = 0;
+    char *base = SegmentMapping(segment, &length);
+    //The kernel reads maxnode - 1 bits
+    if (0 != syscall(SYS_mbind, base, length, mode, nodeMask, BOCOM_PRIV_MAX_NUMA_NODES + 1, MPOL_MF_MOVE))
+    {
+        LOG("BOCOM_MemoryFlags", "mbind failed !");
+    }
+}
+
+//NUMA node of the page at address, it is faulted in if needed
+static int SegmentNode(const void *address)
+{
+    int node = -1;
+    if (0 != syscall(SYS_get_mempolicy, &node, nullptr, 0, address, MPOL_F_NODE | MPOL_F_ADDR))
+    {
+        LOG("BOCOM_SegmentNode", "get_mempolicy failed !");
+        return -1;
+    }
+    return node;
+}
+
+//MemoryFlags of a segment, applied to the mapping of every process: huge pages and page tables are per mapping.
+//Best effort, what the system refuses is logged and the segment works as usual
+static void ApplyMemoryFlags(managed_shared_memory *segment, int flags)
+{
+    const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    size_t length = 0;
+    char *base = SegmentMapping(segment, &length);
+
+    if ((flags & MemHugePages) && 0 != madvise(base, length, MADV_HUGEPAGE))
+    {
+        LOG("BOCOM_MemoryFlags", "transparent huge pages are not available !");
+    }
+    if (flags & MemLock)
+    {
+        //mlock faults every page in as well
+        if (0 == mlock(base, length))
+        {
+            return;
+        }
+        LOG("BOCOM_MemoryFlags", "mlock failed, check RLIMIT_MEMLOCK !");
+    }
+    if (0 == (flags & (MemPrefault | MemLock)))
+    {
+        return;
+    }
+#ifdef MADV_POPULATE_WRITE
+    if (0 == madvise(base, length, MADV_POPULATE_WRITE))
+    {
+        return;
+    }
+#endif
+    //Older kernels: touch every page. Other processes may be writing already, hence an atomic no-op write
+    for (size_t offset = 0; offset < length; offset += pageSize)
+    {
+        __atomic_fetch_or(base + offset, 0, __ATOMIC_RELAXED);
+    }
+}
+
+static size_t IovLength(const struct iovec *iov, int iovcnt)
+{
+    size_t length = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        length += iov[i].iov_len;
+    }
+    return length;
+}
+
+//Copy the user fragments one after the other into dst
+static void GatherIov(void *dst, const struct iovec *iov, int iovcnt)
+{
+    char *pos = static_cast<char *>(dst);
+    for (int i = 0; i < iovcnt; i++)
+    {
+        std::memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+        pos += iov[i].iov_len;
+    }
+}
+
+//Spread length bytes of src over the user fragments, as much as fits
+static void ScatterIov(const struct iovec *iov, int iovcnt, const void *src, size_t length)
+{
+    const char *pos = static_cast<const char *>(src);
+    for (int i = 0; i < iovcnt && length > 0; i++)
+    {
+        const size_t part = std::min(length, iov[i].iov_len);
+        std::memcpy(iov[i].iov_base, pos, part);
+        pos += part;
+        length -= part;
+    }
+}
+
+static socklen_t ReaderFdAddress(uint32_t pid, uint32_t serial, sockaddr_un *addr)
+{
+    std::memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    //Abstract namespace: sun_path starts with a NUL, nothing is left behind in the file system
+    const int len = snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1, "bocom-%u-%u", pid, serial);
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + len);
+}
+
+//Publishers look whether anyone waits with a plain load and no fence. A process that starts waiting makes
+//every running thread pass a full barrier once: a publisher that still read the old count has its data
+//visible to the waiter afterwards, any later publish sees the new count
+static void SyncPublishers()
+{
+    if (0 != syscall(SYS_membarrier, MEMBARRIER_CMD_GLOBAL, 0))
+    {
+        //Without it a publish that overlaps the registration may go unsignalled, later ones are not affected
+        LOG("BOCOM_SyncPublishers", "membarrier is not available !");
+    }
+}
+
+//Bind a non-blocking datagram socket and enter its address in the table, armed
+static int RegisterReaderFd(ReaderFdTable *table, int *slot)
+{
+    static std::atomic<uint32_t> serials(0);
+    for (int i = 0; i < BOCOM_PRIV_MAX_READER_FDS; i++)
+    {
+        ReaderFdType &reader = table->readers[i];
+        uint32_t expected = 0;
+        if (!reader.state.compare_exchange_strong(expected, 1))
+        {
+            continue;
+        }
+
+        reader.pid = static_cast<uint32_t>(getpid());
+        reader.serial = serials.fetch_add(1);
+        sockaddr_un addr;
+        const socklen_t addrLen = ReaderFdAddress(reader.pid, reader.serial, &addr);
+        const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || 0 != bind(fd, reinterpret_cast<sockaddr *>(&addr), addrLen))
+        {
+            LOG("BOCOM_RegisterReaderFd", "cannot bind the reader socket !");
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            reader.state.store(0);
+            return -1;
+        }
+        reader.armed.store(1);
+        reader.state.store(2);
+        table->registered.fetch_add(1);
+        SyncPublishers();
+        *slot = i;
+        return fd;
+    }
+    LOG("BOCOM_RegisterReaderFd", "too many reader descriptors !");
+    return -1;
+}
+
+static void UnregisterReaderFd(ReaderFdTable *table, int slot, int fd)
+{
+    close(fd);
+    uint32_t expected = 2;
+    if (table->readers[slot].state.compare_exchange_strong(expected, 0))
+    {
+        table->registered.fetch_sub(1);
+    }
+}
+
+//Called by publishers once the new data is visible. Nothing but a relaxed load while no descriptor is
+//registered, see SyncPublishers. Otherwise the fence pairs with ArmReaderFd: either the reader sees the
+//data when it looks again after arming, or the publisher sees it armed
+static void SignalReaderFds(ReaderFdTable *table)
+{
+    if (nullptr == table || 0 == table->registered.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    static const int sender = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    for (auto &reader : table->readers)
+    {
+        if (2 != reader.state.load() || 0 == reader.armed.exchange(0))
+        {
+            continue;
+        }
+        sockaddr_un addr;
+        const socklen_t addrLen = ReaderFdAddress(reader.pid, reader.serial, &addr);
+        const char token = 1;
+        if (sendto(sender, &token, sizeof(token), MSG_DONTWAIT | MSG_NOSIGNAL, reinterpret_cast<sockaddr *>(&addr), addrLen) < 0 &&
+            errno == ECONNREFUSED)
+        {
+            //The reader exited without unregistering
+            uint32_t expected = 2;
+            if (reader.state.compare_exchange_strong(expected, 0))
+            {
+                table->registered.fetch_sub(1);
+            }
+        }
+    }
+}
+
+//Drain the datagrams and arm again. The caller looks for data afterwards: a message published
+//before the arm is found then, one published after it makes the descriptor readable
+static void ArmReaderFd(ReaderFdTable *table, int slot, int fd)
+{
+    char buf[64];
+    while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
     {
-        LOG("BOCOM_GetAddrInShmem", "cannot find objName objectName !");
-        return nullptr;
     }
-    return segment->get_address_from_handle(segment->find<BcomMsgType>(objName).first->second);
+    table->readers[slot].armed.store(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+//What ConstructObject takes besides the buffers, for the longest object name and the Latest mode.
+//The buffers share an allocation with the counters, that allocation may round up by one more alignment
+static managed_shared_memory::size_type ObjectControlSize()
+{
+    using Algorithm = managed_shared_memory::segment_manager::memory_algorithm;
+    char objectName[BOCOM_PRIV_NAME_LEN] = {0};
+    memset(objectName, 'x', BOCOM_PRIV_NAME_LEN - 1 - strlen("BOCOM_PRIV_CONDPUB_"));
+
+    return Algorithm::Alignment + NamedObjectsSize([&objectName](managed_heap_memory *scratch) {
+        char this_rwlock[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_RWLOCK_";
+        strcat(this_rwlock, objectName);
+        scratch->construct<RwlockType>(this_rwlock)();
+
+        char this_cond_pub[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_CONDPUB_";
+        strcat(this_cond_pub, objectName);
+        scratch->construct<CondPubType>(this_cond_pub)();
+
+        scratch->allocate(BOCOM_PRIV_CACHE_LINE + sizeof(StatsType) + sizeof(LatestType));
+        scratch->construct<BcomMsgType>(objectName)(0, 0, 0, Latest, 0);
+    });
 }
 
 static Context CreateChannel(st_CHANNAL_INFO *info)
@@ -84,7 +635,17 @@ static Context CreateChannel(st_CHANNAL_INFO *info)
     shared_memory_object::remove(info->channelName);
 
     //Construct managed shared memory
-    managed_shared_memory *segment = new managed_shared_memory(create_only, info->channelName, (info->channelSize + 1024));
+    managed_shared_memory::size_type controlBytes = NamedObjectsSize([](managed_heap_memory *scratch) {
+        scratch->construct<int>("BOCOM_PRIV_MEMORY_FLAGS")(0);
+    });
+    if (info->objectCount > 0)
+    {
+        controlBytes += static_cast<managed_shared_memory::size_type>(info->objectCount) * ObjectControlSize();
+    }
+    managed_shared_memory *segment = new managed_shared_memory(create_only, info->channelName, (info->channelSize + 1024 + controlBytes));
+    segment->construct<int>("BOCOM_PRIV_MEMORY_FLAGS")(info->memoryFlags);
+    BindSegment(segment, info->memoryFlags, info->numaNode);
+    ApplyMemoryFlags(segment, info->memoryFlags);
 
     LOG("BOCOM_CreateChannel", "SUCCESS!");
 
@@ -98,6 +659,21 @@ static ErrorCode ConstructObject(Context chnCtx, st_OBJECT_INFO *info)
         LOG("BOCOM_ConstructObject", "param is null !");
         return ComError;
     }
+    if (info->objectMode != RwLock && info->objectMode != SeqLock && info->objectMode != Latest)
+    {
+        LOG("BOCOM_ConstructObject", "objectMode is illegal !");
+        return Invalid;
+    }
+    uint32_t slotCount = 1;
+    if (info->objectMode == Latest)
+    {
+        slotCount = (info->slotCount == 0) ? BOCOM_PRIV_DEFAULT_SLOTS : info->slotCount;
+        if (slotCount < 2 || slotCount > BOCOM_PRIV_MAX_SLOTS)
+        {
+            LOG("BOCOM_ConstructObject", "slotCount is illegal !");
+            return Invalid;
+        }
+    }
     managed_shared_memory *segment = static_cast<managed_shared_memory *>(chnCtx);
 
     try
@@ -110,8 +686,11 @@ static ErrorCode ConstructObject(Context chnCtx, st_OBJECT_INFO *info)
         strcat(this_cond_pub, info->objectName);
         segment->construct<CondPubType>(this_cond_pub)();
 
-        //Allocate a portion of the segment (raw memory)
-        void *shptr = AllocInShmem(segment, info->objectSize);
+        //Allocate a portion of the segment (raw memory): the buffers, then the counters on a cache line boundary
+        //and for Latest its buffer state
+        const size_t dataBytes = static_cast<size_t>(info->objectSize) * slotCount;
+        const size_t latestBytes = (info->objectMode == Latest) ? sizeof(LatestType) : 0;
+        void *shptr = AllocInShmem(segment, dataBytes + BOCOM_PRIV_CACHE_LINE + sizeof(StatsType) + latestBytes);
         if (shptr == nullptr)
         {
             return MemLack;
@@ -119,9 +698,17 @@ static ErrorCode ConstructObject(Context chnCtx, st_OBJECT_INFO *info)
         //An handle from the base address can identify any byte of the shared
         //memory segment even if it is mapped in different base addresses
         managed_shared_memory::handle_t handle = segment->get_handle_from_address(shptr);
+        char *stats = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(shptr) + dataBytes + BOCOM_PRIV_CACHE_LINE - 1) &
+                                               ~static_cast<uintptr_t>(BOCOM_PRIV_CACHE_LINE - 1));
+        new (stats) StatsType(info->statsFlags);
+        if (0 != latestBytes)
+        {
+            new (stats + sizeof(StatsType)) LatestType();
+        }
 
         //Create an handle of BcomMsgType in segment
-        segment->construct<BcomMsgType>(info->objectName)(info->objectSize, handle);
+        segment->construct<BcomMsgType>(info->objectName)(info->objectSize, handle, segment->get_handle_from_address(stats),
+                                                           info->objectMode, slotCount);
     }
     catch (interprocess_exception &ex)
     {
@@ -169,7 +756,7 @@ static ErrorCode DestroyObject(Context chnCtx, st_OBJECT_INFO *info)
             LOG("BOCOM_DestroyObject", "cannot find objectName !");
             return ComError;
         }
-        void *msg = segment->get_address_from_handle(segment->find<BcomMsgType>(info->objectName).first->second);
+        void *msg = segment->get_address_from_handle(segment->find<BcomMsgType>(info->objectName).first->handle);
         if (msg != nullptr)
         {
             segment->deallocate(msg);
@@ -201,199 +788,1986 @@ static ErrorCode DestroyObject(Context chnCtx, st_OBJECT_INFO *info)
     return Success;
 }
 
-static ErrorCode Publish(Context chnCtx, char *objectName, void *value, int valueLength, int flags)
+static ErrorCode ResolveObject(managed_shared_memory *segment, const char *objectName, ObjectContext *objCtx)
 {
-    if (chnCtx == nullptr || value == nullptr)
+    char this_rwlock[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_RWLOCK_";
+    strcat(this_rwlock, objectName);
+    objCtx->rwlock = segment->find<RwlockType>(this_rwlock).first;
+    if (nullptr == objCtx->rwlock)
     {
-        LOG("BOCOM_Publish", "param is null !");
+        LOG("BOCOM_ResolveObject", "cannot find rwlock !");
         return ComError;
     }
-    managed_shared_memory *segment = static_cast<managed_shared_memory *>(chnCtx);
 
-    try
+    char this_cond_pub[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_CONDPUB_";
+    strcat(this_cond_pub, objectName);
+    objCtx->cond_pub = segment->find<CondPubType>(this_cond_pub).first;
+    if (nullptr == objCtx->cond_pub)
     {
-        char this_rwlock[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_RWLOCK_";
-        strcat(this_rwlock, objectName);
-        RwlockType *rwlock = segment->find<RwlockType>(this_rwlock).first;
-        if (nullptr == rwlock)
-        {
-            LOG("BOCOM_Publish", "data is nullptr !");
-            return ComError;
-        }
-
-        if (0 == flags)
-        {
-            //Non-blocking
-            return ComError;
-        }
-        else if (1 == flags || 2 == flags)
-        {
-            scoped_lock<interprocess_upgradable_mutex> lock(*rwlock);
-            void *msg_data = GetAddrInShmem(segment, objectName);
-            if (nullptr == msg_data)
-            {
-                LOG("BOCOM_Publish", "data is nullptr !");
-                return ComError;
-            }
-            memcpy(msg_data, value, valueLength);
-        }
-        else
-        {
-            LOG("BOCOM_Publish", "flags is illegal !");
-            return ComError;
-        }
-
-        if (2 == flags)
-        {
-            char this_cond_pub[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_CONDPUB_";
-            strcat(this_cond_pub, objectName);
-            CondPubType *cond_pub = segment->find<CondPubType>(this_cond_pub).first;
-            cond_pub->notify_all();
-        }
+        LOG("BOCOM_ResolveObject", "cannot find condition !");
+        return ComError;
     }
-    catch (interprocess_exception &ex)
+
+    BcomMsgType *msg = segment->find<BcomMsgType>(objectName).first;
+    if (nullptr == msg)
     {
-        LOG("", ex.what());
+        LOG("BOCOM_ResolveObject", "cannot find objectName !");
         return ComError;
     }
+    objCtx->msg = msg;
+    objCtx->stats = static_cast<StatsType *>(segment->get_address_from_handle(msg->stats));
+    objCtx->latest = (msg->mode == Latest) ? reinterpret_cast<LatestType *>(objCtx->stats + 1) : nullptr;
+    objCtx->data = segment->get_address_from_handle(msg->handle);
+    objCtx->size = msg->size;
+    objCtx->segment = segment;
     return Success;
 }
 
-static Context JoinChannel(char *channelName)
-{
-    managed_shared_memory *segment = new managed_shared_memory(open_only, channelName);
-
-    LOG("BOCOM_JoinChannel", "SUCCESS!");
-
-    return static_cast<Context>(segment);
-}
-
-static ErrorCode Retrieve(Context chnCtx, char *objectName, void *outPutValue, int valueLength, int flags)
+static ObjectContext *OpenObject(Context chnCtx, const char *objectName)
 {
-    if (chnCtx == nullptr || outPutValue == nullptr)
+    if (chnCtx == nullptr || objectName == nullptr)
     {
-        LOG("BOCOM_Retrieve", "param is null !");
-        return ComError;
+        LOG("BOCOM_OpenObject", "param is null !");
+        return nullptr;
     }
-
     managed_shared_memory *segment = static_cast<managed_shared_memory *>(chnCtx);
 
+    auto *objCtx = new ObjectContext;
     try
     {
-        char this_rwlock[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_RWLOCK_";
-        strcat(this_rwlock, objectName);
-        RwlockType *rwlock = segment->find<RwlockType>(this_rwlock).first;
-        if (nullptr == rwlock)
+        if (Success != ResolveObject(segment, objectName, objCtx))
+        {
+            delete objCtx;
+            return nullptr;
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("OpenObject", ex.what());
+        delete objCtx;
+        return nullptr;
+    }
+    return objCtx;
+}
+
+static ErrorCode CloseObject(ObjectContext *objCtx)
+{
+    if (objCtx == nullptr)
+    {
+        LOG("BOCOM_CloseObject", "param is null !");
+        return ComError;
+    }
+    if (objCtx->readerFd >= 0)
+    {
+        UnregisterReaderFd(&objCtx->msg->readers, objCtx->readerSlot, objCtx->readerFd);
+    }
+    delete objCtx;
+    return Success;
+}
+
+static DeadlineType DeadlineAfter(int timeoutMs)
+{
+    return boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(timeoutMs);
+}
+
+//No deadline means waiting forever
+static bool DeadlinePassed(const DeadlineType *deadline)
+{
+    return nullptr != deadline && boost::posix_time::microsec_clock::universal_time() >= *deadline;
+}
+
+//What a call that could not get through returns: flags 0 never waits, timed calls gave up at the deadline
+static ErrorCode WouldWait(int flags)
+{
+    return (0 == flags) ? Busy : Timeout;
+}
+
+//flags 0 only tries the lock, the others wait for it, at most until the deadline if there is one
+template <class Lock>
+static bool TakeLock(Lock &lock, int flags, const DeadlineType *deadline)
+{
+    if (0 == flags)
+    {
+        return lock.try_lock();
+    }
+    if (nullptr != deadline)
+    {
+        return lock.timed_lock(*deadline);
+    }
+    lock.lock();
+    return true;
+}
+
+static inline uint64_t NowNs()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+//Bucket 0 below 64ns, then one per power of two
+static inline uint32_t StatsBucket(uint64_t ns)
+{
+    if (ns < 64)
+    {
+        return 0;
+    }
+    const uint32_t bucket = 63 - __builtin_clzll(ns) - 5;
+    return std::min<uint32_t>(bucket, BOCOM_STATS_BUCKETS - 1);
+}
+
+static inline void RecordLockTime(std::atomic<uint64_t> &total, std::atomic<uint64_t> *histogram, uint64_t ns)
+{
+    total.fetch_add(ns, std::memory_order_relaxed);
+    histogram[StatsBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+//For locks kept after the call that took them, see LockTimer::Detach
+//taken 0: the lock was not timed
+static void RecordLockHold(StatsType *stats, uint64_t taken)
+{
+    if (0 == taken)
+    {
+        return;
+    }
+    RecordLockTime(stats->lockHoldNs, stats->lockHold, NowNs() - taken);
+}
+
+//Times one hold of an rwlock: the wait is recorded when it is taken, the hold when it is given back.
+//Declared before the lock guard, so that it records after the guard unlocked
+struct LockTimer
+{
+    //Does nothing unless the queue or object was created with StatsLockTimes
+    explicit LockTimer(StatsType *stats)
+        : stats(stats->lockTimes ? stats : nullptr), start(stats->lockTimes ? NowNs() : 0), taken(0)
+    {
+    }
+
+    ~LockTimer()
+    {
+        Released();
+    }
+
+    //About to wait for the lock again
+    void Waiting()
+    {
+        if (nullptr != stats)
+        {
+            start = NowNs();
+        }
+    }
+
+    void Taken()
+    {
+        if (nullptr != stats)
+        {
+            taken = NowNs();
+            RecordLockTime(stats->lockWaitNs, stats->lockWait, taken - start);
+        }
+    }
+
+    //Restart the hold, e.g. after waiting on a condition that gave the lock back meanwhile
+    void Retaken()
+    {
+        if (nullptr != stats)
+        {
+            taken = NowNs();
+        }
+    }
+
+    void Released()
+    {
+        if (0 != taken)
+        {
+            RecordLockHold(stats, taken);
+            taken = 0;
+        }
+    }
+
+    //The lock outlives the timer: returns when it was taken, for RecordLockHold
+    uint64_t Detach()
+    {
+        const uint64_t when = taken;
+        taken = 0;
+        return when;
+    }
+
+    StatsType *stats;
+    uint64_t start;
+    uint64_t taken;
+};
+
+//single: only one process updates the counter (the Spsc sides), a plain store is enough
+static inline void StatsAdd(std::atomic<uint64_t> &counter, uint64_t n, bool single)
+{
+    if (single)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    else
+    {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+//Outcome of a retrieve (or read release) in the counters, messages: how many it returned
+static void CountRetrieve(StatsType *stats, ErrorCode ret, uint64_t messages = 1, bool single = false)
+{
+    switch (ret)
+    {
+    case DataLost:
+        StatsAdd(stats->dataLost, 1, single);
+        StatsAdd(stats->retrieves, messages, single);
+        break;
+    case Success:
+        StatsAdd(stats->retrieves, messages, single);
+        break;
+    case NoData:
+    case Timeout:
+        StatsAdd(stats->noData, 1, single);
+        break;
+    case Busy:
+        StatsAdd(stats->busy, 1, single);
+        break;
+    default:
+        break;
+    }
+}
+
+static void CountPublish(StatsType *stats, ErrorCode ret, uint64_t messages = 1, bool single = false)
+{
+    if (ret == Success)
+    {
+        StatsAdd(stats->publishes, messages, single);
+    }
+    else if (ret == Busy)
+    {
+        StatsAdd(stats->busy, 1, single);
+    }
+}
+
+static void ReadStats(const StatsType *stats, st_STATS_INFO *info)
+{
+    std::memset(info, 0, sizeof(*info));
+    info->publishes = stats->publishes.load(std::memory_order_relaxed);
+    info->retrieves = stats->retrieves.load(std::memory_order_relaxed);
+    info->dataLost = stats->dataLost.load(std::memory_order_relaxed);
+    info->noData = stats->noData.load(std::memory_order_relaxed);
+    info->busy = stats->busy.load(std::memory_order_relaxed);
+    info->lockWaitNs = stats->lockWaitNs.load(std::memory_order_relaxed);
+    info->lockHoldNs = stats->lockHoldNs.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < BOCOM_STATS_BUCKETS; i++)
+    {
+        info->lockWait[i] = stats->lockWait[i].load(std::memory_order_relaxed);
+        info->lockHold[i] = stats->lockHold[i].load(std::memory_order_relaxed);
+    }
+}
+
+template <class Lock>
+static bool WaitPublish(CondPubType *cond_pub, Lock &lock, const DeadlineType *deadline)
+{
+    if (nullptr != deadline)
+    {
+        return cond_pub->timed_wait(lock, *deadline);
+    }
+    cond_pub->wait(lock);
+    return true;
+}
+
+//Returns false when the deadline passed before the wait
+static bool FutexWait(std::atomic<uint32_t> *word, uint32_t expected, const DeadlineType *deadline)
+{
+    struct timespec timeout = {0, 0};
+    if (nullptr != deadline)
+    {
+        const boost::posix_time::time_duration left = *deadline - boost::posix_time::microsec_clock::universal_time();
+        if (left.is_negative())
+        {
+            return false;
+        }
+        timeout.tv_sec = left.total_seconds();
+        timeout.tv_nsec = (left - boost::posix_time::seconds(left.total_seconds())).total_microseconds() * 1000;
+    }
+    //Not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, (nullptr != deadline) ? &timeout : nullptr, nullptr, 0);
+    return true;
+}
+
+static void FutexWakeAll(std::atomic<uint32_t> *word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+//The seq bump is ordered before the waiters check, a waiter registering later sees the new seq
+static void NotifyPublished(NotifyType *notify)
+{
+    notify->seq.fetch_add(1);
+    if (0 != notify->waiters.load())
+    {
+        FutexWakeAll(&notify->seq);
+    }
+}
+
+//Sleep until a publish bumps seq away from seen. Returns false when the deadline passed first
+static bool WaitPublished(NotifyType *notify, uint32_t seen, const DeadlineType *deadline)
+{
+    notify->waiters.fetch_add(1);
+    bool waited = true;
+    while (waited && notify->seq.load() == seen)
+    {
+        waited = FutexWait(&notify->seq, seen, deadline);
+    }
+    notify->waiters.fetch_sub(1, std::memory_order_relaxed);
+    return waited;
+}
+
+//After a publish with flags 2. RwLock publishers notify cond_pub before they unlock, SeqLock/Latest readers
+//never wait on the rwlock and sleep on the notify futex, so the publisher does not wait for them
+static void NotifyObjectPublish(ObjectContext *objCtx)
+{
+    if (objCtx->msg->mode != RwLock)
+    {
+        NotifyPublished(&objCtx->msg->notify);
+    }
+    SignalReaderFds(&objCtx->msg->readers);
+}
+
+//Publishers exclude each other by making seq odd, readers are never waited for
+static uint64_t SeqBeginWrite(std::atomic<uint64_t> &seq)
+{
+    uint64_t cur = seq.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        if ((cur & 1) == 0 && seq.compare_exchange_weak(cur, cur + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            break;
+        }
+        std::this_thread::yield();
+        cur = seq.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return cur;
+}
+
+static bool SeqTryBeginWrite(std::atomic<uint64_t> &seq, uint64_t *cur)
+{
+    uint64_t expected = seq.load(std::memory_order_relaxed);
+    if ((expected & 1) || !seq.compare_exchange_strong(expected, expected + 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    *cur = expected;
+    return true;
+}
+
+static void SeqEndWrite(std::atomic<uint64_t> &seq, uint64_t cur)
+{
+    seq.store(cur + 2, std::memory_order_release);
+}
+
+static bool SeqLockWrite(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int flags)
+{
+    uint64_t cur = 0;
+    if (0 != flags)
+    {
+        cur = SeqBeginWrite(objCtx->msg->seq);
+    }
+    else if (!SeqTryBeginWrite(objCtx->msg->seq, &cur))
+    {
+        return false;
+    }
+    GatherIov(objCtx->data, iov, iovcnt);
+    SeqEndWrite(objCtx->msg->seq, cur);
+    return true;
+}
+
+//Copy optimistically and retry when a publisher ran in between. flags 0 makes a single attempt
+static bool SeqLockRead(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int valueLength, int flags, const DeadlineType *deadline)
+{
+    const std::atomic<uint64_t> &seq = objCtx->msg->seq;
+    for (;;)
+    {
+        const uint64_t begin = seq.load(std::memory_order_acquire);
+        if ((begin & 1) == 0)
+        {
+            ScatterIov(iov, iovcnt, objCtx->data, valueLength);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == begin)
+            {
+                return true;
+            }
+        }
+        if (0 == flags || DeadlinePassed(deadline))
+        {
+            return false;
+        }
+        if (begin & 1)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static inline char *LatestSlot(ObjectContext *objCtx, uint32_t slot)
+{
+    return static_cast<char *>(objCtx->data) + static_cast<size_t>(slot) * objCtx->size;
+}
+
+//Pick a buffer that is neither the latest one nor pinned, LatestEndWrite flips latest to it
+static bool LatestFreeSlot(ObjectContext *objCtx, uint32_t *slot)
+{
+    const uint32_t slotCount = objCtx->msg->slotCount;
+    const uint32_t latest = objCtx->latest->latest.load(std::memory_order_relaxed);
+    for (uint32_t i = 1; i < slotCount; i++)
+    {
+        const uint32_t candidate = (latest + i) % slotCount;
+        if (0 == objCtx->latest->pins[candidate].load())
+        {
+            *slot = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+//Only waits when every other buffer is pinned, i.e. with slotCount - 1 readers copying at once
+static uint32_t LatestBeginWrite(ObjectContext *objCtx, uint64_t *cur)
+{
+    BcomMsgType *msg = objCtx->msg;
+    *cur = SeqBeginWrite(msg->seq);
+    uint32_t slot = 0;
+    while (!LatestFreeSlot(objCtx, &slot))
+    {
+        std::this_thread::yield();
+    }
+    return slot;
+}
+
+static bool LatestTryBeginWrite(ObjectContext *objCtx, uint64_t *cur, uint32_t *slot)
+{
+    BcomMsgType *msg = objCtx->msg;
+    if (!SeqTryBeginWrite(msg->seq, cur))
+    {
+        return false;
+    }
+    if (!LatestFreeSlot(objCtx, slot))
+    {
+        //Nothing was written, readers may keep what they copied meanwhile
+        msg->seq.store(*cur, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+static void LatestEndWrite(ObjectContext *objCtx, uint32_t slot, uint64_t cur)
+{
+    objCtx->latest->latest.store(slot);
+    SeqEndWrite(objCtx->msg->seq, cur);
+}
+
+static bool LatestWrite(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int flags)
+{
+    uint64_t cur = 0;
+    uint32_t slot = 0;
+    if (0 != flags)
+    {
+        slot = LatestBeginWrite(objCtx, &cur);
+    }
+    else if (!LatestTryBeginWrite(objCtx, &cur, &slot))
+    {
+        return false;
+    }
+    GatherIov(LatestSlot(objCtx, slot), iov, iovcnt);
+    LatestEndWrite(objCtx, slot, cur);
+    return true;
+}
+
+//Pin the latest buffer. If latest moved before the pin was visible the buffer may be reused, so retry
+static uint32_t LatestPin(ObjectContext *objCtx)
+{
+    LatestType *state = objCtx->latest;
+    for (;;)
+    {
+        const uint32_t slot = state->latest.load();
+        state->pins[slot].fetch_add(1);
+        if (state->latest.load() == slot)
+        {
+            return slot;
+        }
+        state->pins[slot].fetch_sub(1, std::memory_order_release);
+    }
+}
+
+static void LatestUnpin(ObjectContext *objCtx, uint32_t slot)
+{
+    objCtx->latest->pins[slot].fetch_sub(1, std::memory_order_release);
+}
+
+static void LatestRead(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int valueLength)
+{
+    const uint32_t slot = LatestPin(objCtx);
+    ScatterIov(iov, iovcnt, LatestSlot(objCtx, slot), valueLength);
+    LatestUnpin(objCtx, slot);
+}
+
+static ErrorCode WriteObjectV(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int flags)
+{
+    if (objCtx == nullptr || iov == nullptr)
+    {
+        LOG("BOCOM_Publish", "param is null !");
+        return ComError;
+    }
+    if (iovcnt < 0 || IovLength(iov, iovcnt) > static_cast<size_t>(objCtx->size))
+    {
+        LOG("BOCOM_Publish", "valueLength is larger than objectSize !");
+        return Invalid;
+    }
+
+    if (0 != flags && 1 != flags && 2 != flags)
+    {
+        LOG("BOCOM_Publish", "flags is illegal !");
+        return ComError;
+    }
+
+    try
+    {
+        if (objCtx->msg->mode == SeqLock)
+        {
+            if (!SeqLockWrite(objCtx, iov, iovcnt, flags))
+            {
+                return Busy;
+            }
+        }
+        else if (objCtx->msg->mode == Latest)
+        {
+            if (!LatestWrite(objCtx, iov, iovcnt, flags))
+            {
+                return Busy;
+            }
+        }
+        else
+        {
+            LockTimer timer(objCtx->stats);
+            scoped_lock<interprocess_upgradable_mutex> lock(*objCtx->rwlock, defer_lock);
+            if (!TakeLock(lock, flags, nullptr))
+            {
+                return Busy;
+            }
+            timer.Taken();
+            GatherIov(objCtx->data, iov, iovcnt);
+            if (2 == flags)
+            {
+                objCtx->cond_pub->notify_all();
+            }
+        }
+
+        if (2 == flags)
+        {
+            NotifyObjectPublish(objCtx);
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("", ex.what());
+        return ComError;
+    }
+    return Success;
+}
+
+static ErrorCode PublishObjectV(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int flags)
+{
+    const ErrorCode ret = WriteObjectV(objCtx, iov, iovcnt, flags);
+    if (objCtx != nullptr)
+    {
+        CountPublish(objCtx->stats, ret);
+    }
+    return ret;
+}
+
+static ErrorCode PublishObject(ObjectContext *objCtx, const void *value, int valueLength, int flags)
+{
+    if (objCtx == nullptr || value == nullptr)
+    {
+        LOG("BOCOM_Publish", "param is null !");
+        return ComError;
+    }
+    if (valueLength < 0)
+    {
+        LOG("BOCOM_Publish", "valueLength is illegal !");
+        return Invalid;
+    }
+    const struct iovec iov = {const_cast<void *>(value), static_cast<size_t>(valueLength)};
+    return PublishObjectV(objCtx, &iov, 1, flags);
+}
+
+static ErrorCode Publish(Context chnCtx, char *objectName, void *value, int valueLength, int flags)
+{
+    if (chnCtx == nullptr || value == nullptr)
+    {
+        LOG("BOCOM_Publish", "param is null !");
+        return ComError;
+    }
+    managed_shared_memory *segment = static_cast<managed_shared_memory *>(chnCtx);
+
+    ObjectContext objCtx;
+    try
+    {
+        if (Success != ResolveObject(segment, objectName, &objCtx))
+        {
+            LOG("BOCOM_Publish", "data is nullptr !");
+            return ComError;
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("", ex.what());
+        return ComError;
+    }
+    return PublishObject(&objCtx, value, valueLength, flags);
+}
+
+static ErrorCode AcquireObjectWrite(ObjectContext *objCtx, void **ptr, int flags)
+{
+    if (objCtx == nullptr || ptr == nullptr)
+    {
+        LOG("BOCOM_AcquireObjectWrite", "param is null !");
+        return ComError;
+    }
+    if (0 != objCtx->guard)
+    {
+        LOG("BOCOM_AcquireObjectWrite", "object is acquired already !");
+        return Invalid;
+    }
+    if (0 != flags && 1 != flags && 2 != flags)
+    {
+        LOG("BOCOM_AcquireObjectWrite", "flags is illegal !");
+        return ComError;
+    }
+
+    try
+    {
+        if (objCtx->msg->mode == SeqLock)
+        {
+            if (0 != flags)
+            {
+                objCtx->guardSeq = SeqBeginWrite(objCtx->msg->seq);
+            }
+            else if (!SeqTryBeginWrite(objCtx->msg->seq, &objCtx->guardSeq))
+            {
+                objCtx->stats->busy.fetch_add(1, std::memory_order_relaxed);
+                return Busy;
+            }
+            *ptr = objCtx->data;
+        }
+        else if (objCtx->msg->mode == Latest)
+        {
+            if (0 != flags)
+            {
+                objCtx->guardSlot = LatestBeginWrite(objCtx, &objCtx->guardSeq);
+            }
+            else if (!LatestTryBeginWrite(objCtx, &objCtx->guardSeq, &objCtx->guardSlot))
+            {
+                objCtx->stats->busy.fetch_add(1, std::memory_order_relaxed);
+                return Busy;
+            }
+            //Start from the current value, so that updating a few fields keeps the others
+            char *slot = LatestSlot(objCtx, objCtx->guardSlot);
+            memcpy(slot, LatestSlot(objCtx, objCtx->latest->latest.load()), objCtx->size);
+            *ptr = slot;
+        }
+        else
+        {
+            LockTimer timer(objCtx->stats);
+            scoped_lock<interprocess_upgradable_mutex> lock(*objCtx->rwlock, defer_lock);
+            if (!TakeLock(lock, flags, nullptr))
+            {
+                objCtx->stats->busy.fetch_add(1, std::memory_order_relaxed);
+                return Busy;
+            }
+            timer.Taken();
+            //Keep the lock until ReleaseObject
+            lock.release();
+            objCtx->guardTime = timer.Detach();
+            *ptr = objCtx->data;
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("AcquireObjectWrite", ex.what());
+        return ComError;
+    }
+    objCtx->guard = 2;
+    objCtx->guardFlags = flags;
+    return Success;
+}
+
+static ErrorCode AcquireObjectRead(ObjectContext *objCtx, const void **ptr, int flags)
+{
+    if (objCtx == nullptr || ptr == nullptr)
+    {
+        LOG("BOCOM_AcquireObjectRead", "param is null !");
+        return ComError;
+    }
+    if (0 != objCtx->guard)
+    {
+        LOG("BOCOM_AcquireObjectRead", "object is acquired already !");
+        return Invalid;
+    }
+    if (0 != flags && 1 != flags && 2 != flags)
+    {
+        LOG("BOCOM_AcquireObjectRead", "flags is illegal !");
+        return ComError;
+    }
+    if (objCtx->readerFd >= 0)
+    {
+        ArmReaderFd(&objCtx->msg->readers, objCtx->readerSlot, objCtx->readerFd);
+    }
+
+    try
+    {
+        if (objCtx->msg->mode == RwLock)
+        {
+            LockTimer timer(objCtx->stats);
+            sharable_lock<interprocess_upgradable_mutex> lock(*objCtx->rwlock, defer_lock);
+            if (!TakeLock(lock, flags, nullptr))
+            {
+                objCtx->stats->busy.fetch_add(1, std::memory_order_relaxed);
+                return Busy;
+            }
+            timer.Taken();
+            if (2 == flags)
+            {
+                objCtx->cond_pub->wait(lock);
+                timer.Retaken();
+            }
+            //Keep the sharable lock until ReleaseObject
+            lock.release();
+            objCtx->guardTime = timer.Detach();
+            *ptr = objCtx->data;
+        }
+        else
+        {
+            if (2 == flags)
+            {
+                WaitPublished(&objCtx->msg->notify, objCtx->msg->notify.seq.load(), nullptr);
+            }
+            if (objCtx->msg->mode == SeqLock)
+            {
+                //Reads are validated by ReleaseObject
+                uint64_t begin = objCtx->msg->seq.load(std::memory_order_acquire);
+                while (begin & 1)
+                {
+                    if (0 == flags)
+                    {
+                        objCtx->stats->busy.fetch_add(1, std::memory_order_relaxed);
+                        return Busy;
+                    }
+                    std::this_thread::yield();
+                    begin = objCtx->msg->seq.load(std::memory_order_acquire);
+                }
+                objCtx->guardSeq = begin;
+                *ptr = objCtx->data;
+            }
+            else
+            {
+                objCtx->guardSlot = LatestPin(objCtx);
+                *ptr = LatestSlot(objCtx, objCtx->guardSlot);
+            }
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("AcquireObjectRead", ex.what());
+        return ComError;
+    }
+    objCtx->guard = 1;
+    objCtx->guardFlags = flags;
+    return Success;
+}
+
+static ErrorCode ReleaseObject(ObjectContext *objCtx)
+{
+    if (objCtx == nullptr)
+    {
+        LOG("BOCOM_ReleaseObject", "param is null !");
+        return ComError;
+    }
+    if (0 == objCtx->guard)
+    {
+        LOG("BOCOM_ReleaseObject", "object is not acquired !");
+        return Invalid;
+    }
+    const int guard = objCtx->guard;
+    objCtx->guard = 0;
+
+    ErrorCode ret = Success;
+    try
+    {
+        if (2 == guard)
+        {
+            if (objCtx->msg->mode == SeqLock)
+            {
+                SeqEndWrite(objCtx->msg->seq, objCtx->guardSeq);
+            }
+            else if (objCtx->msg->mode == Latest)
+            {
+                LatestEndWrite(objCtx, objCtx->guardSlot, objCtx->guardSeq);
+            }
+            else
+            {
+                if (2 == objCtx->guardFlags)
+                {
+                    objCtx->cond_pub->notify_all();
+                }
+                objCtx->rwlock->unlock();
+                RecordLockHold(objCtx->stats, objCtx->guardTime);
+            }
+            objCtx->stats->publishes.fetch_add(1, std::memory_order_relaxed);
+            if (2 == objCtx->guardFlags)
+            {
+                NotifyObjectPublish(objCtx);
+            }
+        }
+        else if (objCtx->msg->mode == SeqLock)
+        {
+            //A publisher ran while the object was read in place, what was read may be torn
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (objCtx->msg->seq.load(std::memory_order_relaxed) != objCtx->guardSeq)
+            {
+                ret = DataLost;
+            }
+        }
+        else if (objCtx->msg->mode == Latest)
+        {
+            LatestUnpin(objCtx, objCtx->guardSlot);
+        }
+        else
+        {
+            objCtx->rwlock->unlock_sharable();
+            RecordLockHold(objCtx->stats, objCtx->guardTime);
+        }
+        if (1 == guard)
+        {
+            CountRetrieve(objCtx->stats, ret);
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("ReleaseObject", ex.what());
+        return ComError;
+    }
+    return ret;
+}
+
+static int GetObjectFd(ObjectContext *objCtx)
+{
+    if (objCtx == nullptr)
+    {
+        LOG("BOCOM_GetObjectFd", "param is null !");
+        return -1;
+    }
+    if (objCtx->readerFd < 0)
+    {
+        objCtx->readerFd = RegisterReaderFd(&objCtx->msg->readers, &objCtx->readerSlot);
+    }
+    return objCtx->readerFd;
+}
+
+static int GetObjectNode(ObjectContext *objCtx)
+{
+    if (objCtx == nullptr)
+    {
+        LOG("BOCOM_GetObjectNode", "param is null !");
+        return -1;
+    }
+    return SegmentNode(objCtx->data);
+}
+
+static ErrorCode GetObjectStats(ObjectContext *objCtx, st_STATS_INFO *stats)
+{
+    if (objCtx == nullptr || stats == nullptr)
+    {
+        LOG("BOCOM_GetObjectStats", "param is null !");
+        return ComError;
+    }
+    ReadStats(objCtx->stats, stats);
+    return Success;
+}
+
+static Context JoinChannel(char *channelName)
+{
+    managed_shared_memory *segment = new managed_shared_memory(open_only, channelName);
+    const int *memoryFlags = segment->find<int>("BOCOM_PRIV_MEMORY_FLAGS").first;
+    if (nullptr != memoryFlags)
+    {
+        ApplyMemoryFlags(segment, *memoryFlags);
+    }
+
+    LOG("BOCOM_JoinChannel", "SUCCESS!");
+
+    return static_cast<Context>(segment);
+}
+
+static ErrorCode ReadObjectV(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int flags, const DeadlineType *deadline)
+{
+    if (objCtx == nullptr || iov == nullptr || iovcnt < 0)
+    {
+        LOG("BOCOM_Retrieve", "param is null !");
+        return ComError;
+    }
+    if (0 != flags && 1 != flags && 2 != flags)
+    {
+        LOG("BOCOM_Retrieve", "flags is illegal !");
+        return ComError;
+    }
+    if (objCtx->readerFd >= 0)
+    {
+        //Only publishes after this read make the descriptor readable again
+        ArmReaderFd(&objCtx->msg->readers, objCtx->readerSlot, objCtx->readerFd);
+    }
+
+    try
+    {
+        const int minLen = static_cast<int>(std::min(IovLength(iov, iovcnt), static_cast<size_t>(objCtx->size)));
+        if (objCtx->msg->mode != RwLock)
+        {
+            if (2 == flags && !WaitPublished(&objCtx->msg->notify, objCtx->msg->notify.seq.load(), deadline))
+            {
+                return Timeout;
+            }
+            if (objCtx->msg->mode == SeqLock)
+            {
+                if (!SeqLockRead(objCtx, iov, iovcnt, minLen, flags, deadline))
+                {
+                    return WouldWait(flags);
+                }
+            }
+            else
+            {
+                LatestRead(objCtx, iov, iovcnt, minLen);
+            }
+        }
+        else
+        {
+            LockTimer timer(objCtx->stats);
+            sharable_lock<interprocess_upgradable_mutex> lock(*objCtx->rwlock, defer_lock);
+            if (!TakeLock(lock, flags, deadline))
+            {
+                return WouldWait(flags);
+            }
+            timer.Taken();
+            if (2 == flags)
+            {
+                if (!WaitPublish(objCtx->cond_pub, lock, deadline))
+                {
+                    return Timeout;
+                }
+                timer.Retaken();
+            }
+            ScatterIov(iov, iovcnt, objCtx->data, minLen);
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("", ex.what());
+        return ComError;
+    }
+    return Success;
+}
+
+//deadline: nullptr waits as long as it takes
+static ErrorCode RetrieveObjectV(ObjectContext *objCtx, const struct iovec *iov, int iovcnt, int flags, const DeadlineType *deadline = nullptr)
+{
+    const ErrorCode ret = ReadObjectV(objCtx, iov, iovcnt, flags, deadline);
+    if (objCtx != nullptr)
+    {
+        CountRetrieve(objCtx->stats, ret);
+    }
+    return ret;
+}
+
+static ErrorCode RetrieveObject(ObjectContext *objCtx, void *outPutValue, int valueLength, int flags, const DeadlineType *deadline = nullptr)
+{
+    if (objCtx == nullptr || outPutValue == nullptr || valueLength < 0)
+    {
+        LOG("BOCOM_Retrieve", "param is null !");
+        return ComError;
+    }
+    const struct iovec iov = {outPutValue, static_cast<size_t>(valueLength)};
+    return RetrieveObjectV(objCtx, &iov, 1, flags, deadline);
+}
+
+static ErrorCode Retrieve(Context chnCtx, char *objectName, void *outPutValue, int valueLength, int flags, const DeadlineType *deadline = nullptr)
+{
+    if (chnCtx == nullptr || outPutValue == nullptr)
+    {
+        LOG("BOCOM_Retrieve", "param is null !");
+        return ComError;
+    }
+
+    managed_shared_memory *segment = static_cast<managed_shared_memory *>(chnCtx);
+
+    ObjectContext objCtx;
+    try
+    {
+        if (Success != ResolveObject(segment, objectName, &objCtx))
         {
             LOG("BOCOM_Retrieve", "data is null !");
             return ComError;
         }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("", ex.what());
+        return ComError;
+    }
+    return RetrieveObject(&objCtx, outPutValue, valueLength, flags, deadline);
+}
+
+static bool IsRingMode(QueueMode queueMode)
+{
+    return queueMode == Spsc || queueMode == Mpmc;
+}
+
+static uint32_t RingSlotCount(uint32_t maxQueueSize)
+{
+    uint32_t count = 1;
+    while (count < maxQueueSize)
+    {
+        count <<= 1;
+    }
+    return count;
+}
+
+static uint32_t RingSlotSize(uint32_t maxElementSize)
+{
+    const uint32_t size = sizeof(RingSlotType) + maxElementSize;
+    return (size + BOCOM_PRIV_CACHE_LINE - 1) / BOCOM_PRIV_CACHE_LINE * BOCOM_PRIV_CACHE_LINE;
+}
+
+static inline RingSlotType *RingSlot(const QueueContext *context, uint64_t index)
+{
+    return reinterpret_cast<RingSlotType *>(context->ringSlots + (index & context->ring->mask) * context->ring->slotSize);
+}
+
+static inline char *RingPayload(RingSlotType *slot)
+{
+    return reinterpret_cast<char *>(slot) + sizeof(RingSlotType);
+}
+
+//Single producer: head is private to the publisher, only a full ring makes it touch tail
+static RingSlotType *ReserveSpsc(QueueContext *context, uint64_t *pos)
+{
+    RingQueueType *ring = context->ring;
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+
+    //Drop the oldest message. A consumer copying it fails its own tail CAS and moves on
+    while (head - tail >= ring->depth)
+    {
+        if (ring->tail.compare_exchange_weak(tail, tail + 1, std::memory_order_seq_cst, std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    //The consumer may still be reading the dropped slot in place, it gives it back by ReleaseQueue
+    for (;;)
+    {
+        const uint64_t pinned = ring->pinned.load();
+        if (pinned == 0 || ((pinned - 1) & ring->mask) != (head & ring->mask))
+        {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    *pos = head;
+    return RingSlot(context, head);
+}
+
+static void CommitSpsc(QueueContext *context, RingSlotType *slot, uint64_t pos, unsigned int valueLength)
+{
+    slot->length = valueLength;
+    context->ring->head.store(pos + 1, std::memory_order_release);
+}
+
+static ErrorCode PublishSpsc(QueueContext *context, const struct iovec *iov, int iovcnt, unsigned int valueLength)
+{
+    uint64_t pos = 0;
+    RingSlotType *slot = ReserveSpsc(context, &pos);
+    GatherIov(RingPayload(slot), iov, iovcnt);
+    CommitSpsc(context, slot, pos, valueLength);
+    return Success;
+}
+
+//Single consumer: the copy is only kept if tail did not move under it
+static ErrorCode RetrieveSpsc(QueueContext *context, const struct iovec *iov, int iovcnt, unsigned int *valueLength)
+{
+    RingQueueType *ring = context->ring;
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    for (;;)
+    {
+        if (tail == ring->head.load(std::memory_order_acquire))
+        {
+            return NoData;
+        }
+
+        RingSlotType *slot = RingSlot(context, tail);
+        const uint32_t msgLen = static_cast<uint32_t>(std::min<uint64_t>(slot->length, context->maxElementSize));
+        ScatterIov(iov, iovcnt, RingPayload(slot), msgLen);
+
+        //The release half keeps the copy above before the slot is handed back to the publisher
+        const uint64_t expected = tail;
+        if (ring->tail.compare_exchange_strong(tail, tail + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            if (NULL != valueLength)
+            {
+                *valueLength = msgLen;
+            }
+            //Set the initial value at the first call
+            const bool lost = (context->index != 0) && (expected != context->index);
+            context->index = expected + 1;
+            return lost ? DataLost : Success;
+        }
+        //The publisher dropped the message while it was copied, tail now holds the oldest one
+    }
+}
+
+static ErrorCode PeekSpsc(QueueContext *context, const void **ptr, unsigned int *valueLength)
+{
+    RingQueueType *ring = context->ring;
+    uint64_t tail = 0;
+    for (;;)
+    {
+        tail = ring->tail.load();
+        if (tail == ring->head.load(std::memory_order_acquire))
+        {
+            return NoData;
+        }
+        //Pin first, then make sure the publisher did not drop the slot before it could see the pin
+        ring->pinned.store(tail + 1);
+        if (ring->tail.load() == tail)
+        {
+            break;
+        }
+        ring->pinned.store(0, std::memory_order_relaxed);
+    }
+
+    RingSlotType *slot = RingSlot(context, tail);
+    *ptr = RingPayload(slot);
+    *valueLength = static_cast<uint32_t>(std::min<uint64_t>(slot->length, context->maxElementSize));
+    const bool lost = (context->index != 0) && (tail != context->index);
+    context->index = tail + 1;
+    context->peekToken = tail;
+    return lost ? DataLost : Success;
+}
+
+static void ReleaseSpsc(QueueContext *context)
+{
+    RingQueueType *ring = context->ring;
+    //Fails when the publisher dropped the message meanwhile, it was consumed either way
+    uint64_t expected = context->peekToken;
+    ring->tail.compare_exchange_strong(expected, expected + 1, std::memory_order_acq_rel, std::memory_order_acquire);
+    ring->pinned.store(0, std::memory_order_release);
+}
+
+//Consume the oldest published message without copying it. Fails while that slot is still being written or read.
+//A loan given back without data is retired here as well, it was no message and is not counted as lost
+static bool DropOldestMpmc(QueueContext *context)
+{
+    RingQueueType *ring = context->ring;
+    uint64_t pos = ring->tail.load(std::memory_order_relaxed);
+    RingSlotType *slot = RingSlot(context, pos);
+    if (slot->seq.load(std::memory_order_acquire) != pos + 1 ||
+        !ring->tail.compare_exchange_strong(pos, pos + 1, std::memory_order_relaxed))
+    {
+        return false;
+    }
+    const bool message = (0 != slot->length);
+    slot->seq.store(pos + ring->mask + 1, std::memory_order_release);
+    if (message)
+    {
+        ring->lost.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+//Multiple producers: a slot is claimed by one CAS on head, its seq stamp publishes it
+static RingSlotType *ClaimMpmc(QueueContext *context, uint64_t *claimed)
+{
+    RingQueueType *ring = context->ring;
+    uint64_t pos = ring->head.load(std::memory_order_relaxed);
+    RingSlotType *slot = nullptr;
+    for (;;)
+    {
+        slot = RingSlot(context, pos);
+        const int64_t diff = static_cast<int64_t>(slot->seq.load(std::memory_order_acquire) - pos);
+        const bool full = static_cast<int64_t>(pos - ring->tail.load(std::memory_order_relaxed)) >= ring->depth;
+        if (diff == 0 && !full)
+        {
+            if (ring->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (full)
+        {
+            //Overwrite the oldest message. If its slot is busy the holder finishes a bounded copy soon
+            if (!DropOldestMpmc(context))
+            {
+                std::this_thread::yield();
+            }
+            pos = ring->head.load(std::memory_order_relaxed);
+        }
+        else if (diff < 0)
+        {
+            //Not full, but a consumer still copies or peeks the previous message of this slot: wait for it
+            std::this_thread::yield();
+            pos = ring->head.load(std::memory_order_relaxed);
+        }
+        else
+        {
+            pos = ring->head.load(std::memory_order_relaxed);
+        }
+    }
+
+    *claimed = pos;
+    return slot;
+}
+
+static void CommitMpmc(RingSlotType *slot, uint64_t pos, unsigned int valueLength)
+{
+    slot->length = valueLength;
+    slot->seq.store(pos + 1, std::memory_order_release);
+}
+
+static ErrorCode PublishMpmc(QueueContext *context, const struct iovec *iov, int iovcnt, unsigned int valueLength)
+{
+    uint64_t pos = 0;
+    RingSlotType *slot = ClaimMpmc(context, &pos);
+    GatherIov(RingPayload(slot), iov, iovcnt);
+    CommitMpmc(slot, pos, valueLength);
+    return Success;
+}
 
-        if (0 == flags)
+//Multiple consumers: every message is handed to exactly one of them. The slot stays unusable
+//for the publishers until ReleaseReadMpmc
+static RingSlotType *ClaimReadMpmc(QueueContext *context, uint64_t *claimed)
+{
+    RingQueueType *ring = context->ring;
+    uint64_t pos = ring->tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        RingSlotType *slot = RingSlot(context, pos);
+        const int64_t diff = static_cast<int64_t>(slot->seq.load(std::memory_order_acquire) - (pos + 1));
+        if (diff == 0)
         {
-            //no-blocking
-            return ComError;
+            if (ring->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                if (0 != slot->length)
+                {
+                    *claimed = pos;
+                    return slot;
+                }
+                //A loan given back without data, skip it
+                slot->seq.store(pos + ring->mask + 1, std::memory_order_release);
+                pos = ring->tail.load(std::memory_order_relaxed);
+            }
+        }
+        else if (diff < 0)
+        {
+            return nullptr;
+        }
+        else
+        {
+            pos = ring->tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+//Each drop is reported once, to whichever consumer gets the next message
+static uint64_t TakeLostMpmc(RingQueueType *ring)
+{
+    if (0 == ring->lost.load(std::memory_order_relaxed))
+    {
+        return 0;
+    }
+    return ring->lost.exchange(0, std::memory_order_relaxed);
+}
+
+//dropped: optional, the number of drops reported to this consumer
+static ErrorCode ReleaseReadMpmc(QueueContext *context, RingSlotType *slot, uint64_t pos, uint64_t *dropped = nullptr)
+{
+    RingQueueType *ring = context->ring;
+    slot->seq.store(pos + ring->mask + 1, std::memory_order_release);
+
+    const uint64_t lost = TakeLostMpmc(ring);
+    if (nullptr != dropped)
+    {
+        *dropped = lost;
+    }
+    return (0 != lost) ? DataLost : Success;
+}
+
+static ErrorCode RetrieveMpmc(QueueContext *context, const struct iovec *iov, int iovcnt, unsigned int *valueLength)
+{
+    uint64_t pos = 0;
+    RingSlotType *slot = ClaimReadMpmc(context, &pos);
+    if (nullptr == slot)
+    {
+        return NoData;
+    }
+
+    const uint32_t msgLen = static_cast<uint32_t>(std::min<uint64_t>(slot->length, context->maxElementSize));
+    ScatterIov(iov, iovcnt, RingPayload(slot), msgLen);
+    if (NULL != valueLength)
+    {
+        *valueLength = msgLen;
+    }
+    return ReleaseReadMpmc(context, slot, pos);
+}
+
+static uint32_t PoolBufferSize(uint32_t maxElementSize)
+{
+    return (maxElementSize + BOCOM_PRIV_CACHE_LINE - 1) / BOCOM_PRIV_CACHE_LINE * BOCOM_PRIV_CACHE_LINE;
+}
+
+static uint32_t RecordSize(uint32_t length)
+{
+    return (length + BOCOM_PRIV_RECORD_ALIGN - 1) / BOCOM_PRIV_RECORD_ALIGN * BOCOM_PRIV_RECORD_ALIGN;
+}
+
+//Layout of the slots of a pool queue: the entries, the free list, then the buffers from a cache line boundary.
+//The byte layout has no free list
+static size_t PoolFreeOffset(uint32_t mask)
+{
+    return static_cast<size_t>(mask + 1) * sizeof(PoolEntryType);
+}
+
+static size_t PoolBufferOffset(uint32_t mask, uint32_t freeListLength)
+{
+    const size_t end = PoolFreeOffset(mask) + static_cast<size_t>(freeListLength) * sizeof(uint32_t);
+    return (end + BOCOM_PRIV_CACHE_LINE - 1) / BOCOM_PRIV_CACHE_LINE * BOCOM_PRIV_CACHE_LINE;
+}
+
+//Header and slots of a queue
+static size_t QueueBlockBytes(const st_QUEUE_INFO *info)
+{
+    const uint32_t mask = RingSlotCount(info->maxQueueSize) - 1;
+    if (IsRingMode(info->queueMode))
+    {
+        return sizeof(RingQueueType) + static_cast<size_t>(mask + 1) * RingSlotSize(info->maxElementSize);
+    }
+    if (0 != info->queueBytes)
+    {
+        return sizeof(PoolQueueType) + PoolBufferOffset(mask, 0) + RecordSize(info->queueBytes);
+    }
+    return sizeof(PoolQueueType) + PoolBufferOffset(mask, info->maxQueueSize) +
+           static_cast<size_t>(info->maxQueueSize) * PoolBufferSize(info->maxElementSize);
+}
+
+static void AttachQueue(QueueContext *context)
+{
+    char *header = static_cast<char *>(context->segment->get_address_from_handle(context->block->header));
+    if (IsRingMode(context->queueMode))
+    {
+        context->ring = reinterpret_cast<RingQueueType *>(header);
+        context->ringSlots = header + sizeof(RingQueueType);
+        context->stats = &context->ring->stats;
+        context->notify = &context->ring->notify;
+        return;
+    }
+
+    PoolQueueType *pool = reinterpret_cast<PoolQueueType *>(header);
+    char *slots = header + sizeof(PoolQueueType);
+    context->pool = pool;
+    context->stats = &pool->stats;
+    context->rwlock = &pool->rwlock;
+    context->notify = &pool->notify;
+    context->poolEntries = reinterpret_cast<PoolEntryType *>(slots);
+    context->poolFree = reinterpret_cast<uint32_t *>(slots + PoolFreeOffset(pool->mask));
+    context->poolBuffers = slots + PoolBufferOffset(pool->mask, (0 == pool->ringBytes) ? pool->capacity : 0);
+}
+
+static inline PoolEntryType *PoolEntry(const QueueContext *context, uint64_t index)
+{
+    return &context->poolEntries[index & context->pool->mask];
+}
+
+static inline char *PoolBuffer(const QueueContext *context, uint32_t buffer)
+{
+    return context->poolBuffers + static_cast<size_t>(buffer) * context->pool->bufferSize;
+}
+
+static const PoolEntryType *DropOldestPoolEntry(QueueContext *context)
+{
+    PoolQueueType *pool = context->pool;
+    const PoolEntryType *entry = PoolEntry(context, pool->tail++);
+    pool->usedBytes -= entry->span;
+    return entry;
+}
+
+//Take an unused buffer, or the buffer of the oldest message which is dropped. The caller holds the queue lock.
+//Fails only while the queue is empty and every buffer is loaned
+static bool TakePoolBuffer(QueueContext *context, uint32_t *buffer)
+{
+    PoolQueueType *pool = context->pool;
+    if (pool->freeCount > 0)
+    {
+        *buffer = context->poolFree[--pool->freeCount];
+        return true;
+    }
+    if (pool->head == pool->tail)
+    {
+        return false;
+    }
+    *buffer = DropOldestPoolEntry(context)->buffer;
+    return true;
+}
+
+//Byte layout: reserve a record at the write offset, it never wraps around the end of the ring.
+//The queued messages are contiguous up to the write offset, so dropping the oldest ones frees the room
+//in front of it. CreateQueue made sure a record of maxElementSize fits an empty ring
+static uint32_t TakeRingBytes(QueueContext *context, uint32_t length, uint32_t *span)
+{
+    PoolQueueType *pool = context->pool;
+    const uint32_t size = RecordSize(length);
+    for (;;)
+    {
+        if (pool->head == pool->tail)
+        {
+            pool->usedBytes = 0;
+            pool->writeOffset = 0;
+        }
+        const bool wraps = size > pool->ringBytes - pool->writeOffset;
+        const uint32_t skip = wraps ? pool->ringBytes - pool->writeOffset : 0;
+        if (pool->head - pool->tail < pool->capacity && size + skip <= pool->ringBytes - pool->usedBytes)
+        {
+            const uint32_t offset = wraps ? 0 : pool->writeOffset;
+            pool->writeOffset = offset + size;
+            pool->usedBytes += size + skip;
+            *span = size + skip;
+            return offset;
+        }
+        DropOldestPoolEntry(context);
+    }
+}
+
+//Every queued message owns a distinct buffer (or ring bytes), so head - tail never exceeds capacity and the entry is unused
+static void AppendPoolEntry(QueueContext *context, uint32_t buffer, uint32_t length, uint32_t span)
+{
+    PoolQueueType *pool = context->pool;
+    PoolEntryType *entry = PoolEntry(context, pool->head);
+    entry->index = pool->head;
+    entry->length = length;
+    entry->buffer = buffer;
+    entry->span = span;
+    pool->head++;
+}
+
+//Named control objects of a queue, constructed ahead of its block
+struct QueueControlType
+{
+    ReaderFdTable *readers = nullptr;
+    ConsumerTable *consumers = nullptr;
+    QueueBlockType *block = nullptr;
+};
+
+template <class Segment>
+static QueueControlType ConstructQueueControl(Segment *segment, const st_QUEUE_INFO *info)
+{
+    QueueControlType control;
+    segment->template construct<QueueMode>("BOCOM_PRIV_QUEUE_MODE")(info->queueMode);
+    segment->template construct<QueSizeType>("BOCOM_PRIV_QUEUE_SIZE")(info->maxQueueSize, info->maxElementSize);
+    segment->template construct<int>("BOCOM_PRIV_MEMORY_FLAGS")(info->memoryFlags);
+    control.readers = segment->template construct<ReaderFdTable>("BOCOM_PRIV_QUEUE_READERS")();
+    control.consumers = segment->template construct<ConsumerTable>("BOCOM_PRIV_QUEUE_CONSUMERS")();
+    control.block = segment->template construct<QueueBlockType>(info->queueName)();
+    return control;
+}
+
+//Nothing is freed while a queue is built, so its segment needs exactly the allocator header, the control
+//objects and the block, which is a single allocation
+static managed_shared_memory::size_type QueueSegmentSize(const st_QUEUE_INFO *info, size_t blockBytes)
+{
+    using Algorithm = managed_shared_memory::segment_manager::memory_algorithm;
+    const managed_shared_memory::size_type controlBytes = NamedObjectsSize([info](managed_heap_memory *scratch) {
+        ConstructQueueControl(scratch, info);
+    });
+
+    const managed_shared_memory::size_type slotBlock =
+        (blockBytes + Algorithm::PayloadPerAllocation + Algorithm::Alignment - 1) / Algorithm::Alignment * Algorithm::Alignment;
+    //The mapping starts with the initialization flag of the segment, padded to the allocator alignment
+    return Algorithm::Alignment + managed_shared_memory::segment_manager::get_min_size() + controlBytes + slotBlock;
+}
+
+static QueueContext* CreateQueue(const st_QUEUE_INFO *info)
+{
+    //Erase previous shared memory and schedule erasure on exit
+    shared_memory_object::remove(info->queueName);
+
+    if (info->maxQueueSize <= 0 || info->maxElementSize <= 0)
+    {
+        LOG("BOCOM_CreateQueue", "queue size is illegal !");
+        return nullptr;
+    }
+    if (0 != info->queueBytes &&
+        (IsRingMode(info->queueMode) || info->queueBytes > UINT_MAX - BOCOM_PRIV_RECORD_ALIGN ||
+         RecordSize(info->queueBytes) < RecordSize(info->maxElementSize)))
+    {
+        LOG("BOCOM_CreateQueue", "queueBytes is illegal for this queue !");
+        return nullptr;
+    }
+
+    auto *context = new QueueContext;
+    try
+    {
+        //The allocator only aligns to 16 bytes, the block is placed on the first cache line boundary in it
+        const size_t blockBytes = QueueBlockBytes(info) + BOCOM_PRIV_CACHE_LINE;
+        context->segment = new managed_shared_memory(create_only, info->queueName, QueueSegmentSize(info, blockBytes));
+        managed_shared_memory *segment = context->segment;
+        const QueueControlType control = ConstructQueueControl(segment, info);
+        char *allocation = static_cast<char *>(AllocInShmem(segment, blockBytes));
+        if (nullptr == allocation)
+        {
+            delete context->segment;
+            delete context;
+            shared_memory_object::remove(info->queueName);
+            return nullptr;
         }
-        else if (1 == flags)
+        //Every process maps the segment on a page boundary, so the header is cache line aligned for the joiners too
+        char *header = reinterpret_cast<char *>(
+            (reinterpret_cast<uintptr_t>(allocation) + BOCOM_PRIV_CACHE_LINE - 1) & ~static_cast<uintptr_t>(BOCOM_PRIV_CACHE_LINE - 1));
+        control.block->allocation = segment->get_handle_from_address(allocation);
+        control.block->header = segment->get_handle_from_address(header);
+        context->block = control.block;
+        context->readers = control.readers;
+        context->consumers = control.consumers;
+        context->queueName = info->queueName;
+        context->maxQueueSize = info->maxQueueSize;
+        context->maxElementSize = info->maxElementSize;
+        context->queueMode = info->queueMode;
+
+        const uint32_t mask = RingSlotCount(info->maxQueueSize) - 1;
+        if (IsRingMode(info->queueMode))
         {
-            sharable_lock<interprocess_upgradable_mutex> lock(*rwlock);
-            void *msg = GetAddrInShmem(segment, objectName);
-            if (msg != nullptr)
+            new (header) RingQueueType(info->maxQueueSize, mask, RingSlotSize(info->maxElementSize));
+            AttachQueue(context);
+            for (uint32_t i = 0; i <= mask; i++)
             {
-                int msgLen = segment->find<BcomMsgType>(objectName).first->first;
-                int minLen = std::min(valueLength, msgLen);
-                memcpy(outPutValue, msg, minLen);
+                new (RingSlot(context, i)) RingSlotType{{i}, 0};
             }
-            else
+        }
+        else
+        {
+            const uint32_t ringBytes = RecordSize(info->queueBytes);
+            new (header) PoolQueueType(info->maxQueueSize, mask, (0 == ringBytes) ? PoolBufferSize(info->maxElementSize) : 1, ringBytes);
+            AttachQueue(context);
+            //Popped from the back, so the buffers are first used in address order
+            for (uint32_t i = 0; i < context->pool->freeCount; i++)
             {
-                LOG("BOCOM_Retrieve", "data is null !");
-                return ComError;
+                context->poolFree[i] = context->maxQueueSize - 1 - i;
             }
         }
-        else if (2 == flags)
+        context->stats->lockTimes = (0 != (info->statsFlags & StatsLockTimes));
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("CreateQueue", ex.what());
+        delete context->segment;
+        delete context;
+        shared_memory_object::remove(info->queueName);
+        return nullptr;
+    }
+    BindSegment(context->segment, info->memoryFlags, info->numaNode);
+    ApplyMemoryFlags(context->segment, info->memoryFlags);
+
+    LOG("BOCOM_CreateQueue", "SUCCESS!");
+
+    return context;
+}
+
+static ErrorCode DestroyQueue(QueueContext *context)
+{
+    if (context == nullptr || context->segment == nullptr)
+    {
+        LOG("BOCOM_DestroyQueue", "param is null !");
+        return ComError;
+    }
+    managed_shared_memory *segment = context->segment;
+    if (context->readerFd >= 0)
+    {
+        UnregisterReaderFd(context->readers, context->readerSlot, context->readerFd);
+    }
+    segment->destroy<ReaderFdTable>("BOCOM_PRIV_QUEUE_READERS");
+    segment->destroy<ConsumerTable>("BOCOM_PRIV_QUEUE_CONSUMERS");
+
+    const char *queueName = context->queueName.c_str();
+    if (nullptr != context->pool)
+    {
+        context->pool->~PoolQueueType();
+    }
+    segment->deallocate(segment->get_address_from_handle(context->block->allocation));
+    segment->destroy<QueueBlockType>(queueName);
+
+    shared_memory_object::remove(queueName);
+
+    delete context->segment;
+    context->segment = nullptr;
+    delete context;
+    return Success;
+}
+
+//Append one message, the caller holds the queue lock. No allocation: the message is copied into a pool buffer
+//or packed into the byte ring
+static ErrorCode PushPoolMessage(QueueContext *context, const struct iovec *iov, int iovcnt, unsigned int valueLength)
+{
+    uint32_t buffer = 0;
+    uint32_t span = 0;
+    if (0 != context->pool->ringBytes)
+    {
+        buffer = TakeRingBytes(context, valueLength, &span);
+    }
+    else if (!TakePoolBuffer(context, &buffer))
+    {
+        LOG("BOCOM_Publish", "every buffer is loaned !");
+        return MemLack;
+    }
+    GatherIov(PoolBuffer(context, buffer), iov, iovcnt);
+    AppendPoolEntry(context, buffer, valueLength, span);
+    return Success;
+}
+
+//Take a free entry, or the one of a consumer that exited without quitting. Without one the consumer
+//works as usual but is not listed
+static ConsumerType *RegisterConsumer(ConsumerTable *table)
+{
+    if (nullptr == table)
+    {
+        return nullptr;
+    }
+    const uint32_t self = static_cast<uint32_t>(getpid());
+    for (auto &consumer : table->consumers)
+    {
+        uint32_t expected = 0;
+        if (consumer.state.compare_exchange_strong(expected, 1))
+        {
+            consumer.index.store(0, std::memory_order_relaxed);
+            consumer.pid.store(self);
+            return &consumer;
+        }
+        //Of several processes reclaiming the same entry, only one swaps the pid
+        uint32_t pid = consumer.pid.load();
+        if (0 != pid && 0 != kill(static_cast<pid_t>(pid), 0) && errno == ESRCH &&
+            consumer.pid.compare_exchange_strong(pid, self))
+        {
+            consumer.index.store(0, std::memory_order_relaxed);
+            return &consumer;
+        }
+    }
+    LOG("BOCOM_RegisterConsumer", "too many consumers, this one is not listed !");
+    return nullptr;
+}
+
+//Counters of a retrieve, and the position of this consumer for BOCOM_InspectConsumers
+static void CountQueueRetrieve(QueueContext *context, ErrorCode ret, uint64_t messages = 1)
+{
+    CountRetrieve(context->stats, ret, messages, context->queueMode == Spsc);
+    //Not at join: a process that only publishes is never listed
+    if (!context->retrieved)
+    {
+        context->retrieved = true;
+        context->consumer = RegisterConsumer(context->consumers);
+    }
+    //Mpmc consumers share the messages, their lag is the depth and needs no position
+    if (nullptr != context->consumer && context->queueMode != Mpmc)
+    {
+        context->consumer->index.store(context->index, std::memory_order_relaxed);
+    }
+}
+
+static void CountQueuePublish(QueueContext *context, ErrorCode ret, uint64_t messages = 1)
+{
+    CountPublish(context->stats, ret, messages, context->queueMode == Spsc);
+}
+
+//Wake the consumers waiting for a publish and the readiness descriptors once for everything published since the last call
+static void NotifyQueueReaders(QueueContext *context)
+{
+    //Without a timed reader the other modes pay a relaxed load here, see SyncPublishers
+    if (context->queueMode == Notify || 0 != context->notify->timedReaders.load(std::memory_order_relaxed))
+    {
+        NotifyPublished(context->notify);
+    }
+    SignalReaderFds(context->readers);
+}
+
+static ErrorCode PublishQueueV(QueueContext *context, const struct iovec *iov, int iovcnt)
+{
+    if (context == nullptr || iov == nullptr || iovcnt < 0 || context->segment == nullptr)
+    {
+        LOG("BOCOM_Publish", "param is null !");
+        return ComError;
+    }
+    const size_t totalLength = IovLength(iov, iovcnt);
+    if (totalLength > context->maxElementSize)
+    {
+        LOG("BOCOM_Publish", "valueLength is larger than maxElementSize !");
+        return Invalid;
+    }
+    const unsigned int valueLength = static_cast<unsigned int>(totalLength);
+    if (valueLength == 0)
+    {
+        LOG("BOCOM_Publish", "copy value failed !");
+        return ComError;
+    }
+    if (IsRingMode(context->queueMode))
+    {
+        const ErrorCode ret = (context->queueMode == Spsc) ? PublishSpsc(context, iov, iovcnt, valueLength)
+                                                            : PublishMpmc(context, iov, iovcnt, valueLength);
+        NotifyQueueReaders(context);
+        CountQueuePublish(context, ret);
+        return ret;
+    }
+
+    try
+    {
+        LockTimer timer(context->stats);
+        scoped_lock<interprocess_upgradable_mutex> lock(*context->rwlock);
+        timer.Taken();
+        const ErrorCode ret = PushPoolMessage(context, iov, iovcnt, valueLength);
+        if (ret != Success)
         {
-            sharable_lock<interprocess_upgradable_mutex> lock(*rwlock);
+            return ret;
+        }
+
+        lock.unlock();
+        timer.Released();
+        NotifyQueueReaders(context);
+        CountQueuePublish(context, ret);
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("PublishQueue", ex.what());
+        return ComError;
+    }
+    return Success;
+}
+
+static ErrorCode PublishQueue(QueueContext *context, const void *value, unsigned int valueLength)
+{
+    if (context == nullptr || value == nullptr)
+    {
+        LOG("BOCOM_Publish", "param is null !");
+        return ComError;
+    }
+    const struct iovec iov = {const_cast<void *>(value), valueLength};
+    return PublishQueueV(context, &iov, 1);
+}
 
-            char this_cond_pub[BOCOM_PRIV_NAME_LEN] = "BOCOM_PRIV_CONDPUB_";
-            strcat(this_cond_pub, objectName);
-            CondPubType *cond_pub = segment->find<CondPubType>(this_cond_pub).first;
-            cond_pub->wait(lock);
+//All messages are checked before the first one is published, so an invalid batch publishes nothing
+static ErrorCode PublishQueueBatch(QueueContext *context, const struct iovec *msgs, int count)
+{
+    if (context == nullptr || msgs == nullptr || context->segment == nullptr)
+    {
+        LOG("BOCOM_PublishQueueBatch", "param is null !");
+        return ComError;
+    }
+    if (count <= 0)
+    {
+        LOG("BOCOM_PublishQueueBatch", "count is illegal !");
+        return Invalid;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (msgs[i].iov_base == nullptr || msgs[i].iov_len == 0 || msgs[i].iov_len > context->maxElementSize)
+        {
+            LOG("BOCOM_PublishQueueBatch", "a message is empty or larger than maxElementSize !");
+            return Invalid;
+        }
+    }
 
-            void *msg = GetAddrInShmem(segment, objectName);
-            if (msg != nullptr)
+    if (IsRingMode(context->queueMode))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const unsigned int valueLength = static_cast<unsigned int>(msgs[i].iov_len);
+            if (context->queueMode == Spsc)
             {
-                int msgLen = segment->find<BcomMsgType>(objectName).first->first;
-                int minLen = std::min(valueLength, msgLen);
-                memcpy(outPutValue, msg, minLen);
+                PublishSpsc(context, &msgs[i], 1, valueLength);
             }
             else
             {
-                LOG("BOCOM_Retrieve", "data is null !");
-                return ComError;
+                PublishMpmc(context, &msgs[i], 1, valueLength);
+            }
+        }
+        NotifyQueueReaders(context);
+        CountQueuePublish(context, Success, count);
+        return Success;
+    }
+
+    ErrorCode ret = Success;
+    try
+    {
+        LockTimer timer(context->stats);
+        scoped_lock<interprocess_upgradable_mutex> lock(*context->rwlock);
+        timer.Taken();
+        int published = 0;
+        for (; published < count; published++)
+        {
+            ret = PushPoolMessage(context, &msgs[published], 1, static_cast<unsigned int>(msgs[published].iov_len));
+            if (ret != Success)
+            {
+                break;
             }
         }
-        else
+
+        //What was appended before a failure stays published and is announced like the rest
+        lock.unlock();
+        timer.Released();
+        if (published > 0)
         {
-            LOG("BOCOM_Retrieve", "flags is illegal !");
-            return ComError;
+            NotifyQueueReaders(context);
+            CountQueuePublish(context, Success, published);
         }
     }
     catch (interprocess_exception &ex)
     {
-        LOG("", ex.what());
+        LOG("PublishQueueBatch", ex.what());
         return ComError;
     }
-    return Success;
+    return ret;
 }
 
-static QueueContext* CreateQueue(const st_QUEUE_INFO *info)
+static ErrorCode LoanQueueSlot(QueueContext *context, unsigned int size, void **ptr)
 {
-    //Erase previous shared memory and schedule erasure on exit
-    shared_memory_object::remove(info->queueName);
+    if (context == nullptr || ptr == nullptr || context->segment == nullptr)
+    {
+        LOG("BOCOM_LoanQueueSlot", "param is null !");
+        return ComError;
+    }
+    if (size == 0 || size > context->maxElementSize)
+    {
+        LOG("BOCOM_LoanQueueSlot", "size is larger than maxElementSize !");
+        return Invalid;
+    }
+    if (nullptr != context->loan)
+    {
+        LOG("BOCOM_LoanQueueSlot", "a slot is loaned already !");
+        return Invalid;
+    }
 
-    auto *context = new QueueContext;
-    // TODO: the allocated memory is not sufficient as we don't cout the meta data.
-    context->segment = new managed_shared_memory(create_only, info->queueName, (info->maxElementSize * info->maxQueueSize) + BOCOM_PRIV_HOLD_SIZE);
-    managed_shared_memory *segment = context->segment;
-    try
+    if (context->queueMode == Spsc)
+    {
+        context->loan = RingPayload(ReserveSpsc(context, &context->loanPos));
+    }
+    else if (context->queueMode == Mpmc)
     {
-        //Construct object management deque
-        const ShmemAllocator alloc_inst(segment->get_segment_manager());
-        //Construct a deque in shared memory with argument alloc_inst
-        segment->construct<BcomDequeType>(info->queueName)(alloc_inst);
-        //Construct for save queue size info (maxQueueSize,maxElementSize)
-        segment->construct<QueSizeType>("BOCOM_PRIV_QUEUE_SIZE")(info->maxQueueSize, info->maxElementSize);
-        //Construct for save queue index
-        segment->construct<uint64_t>("BOCOM_PRIV_QUEUE_INDEX")(0);
-        //Construct for rwlock
-        segment->construct<RwlockType>("BOCOM_PRIV_RWLOCK_QUEUE")();
-        //Construct for condition
-        if(info->queueMode == Notify)
+        context->loan = RingPayload(ClaimMpmc(context, &context->loanPos));
+    }
+    else if (0 != context->pool->ringBytes)
+    {
+        //A loaned record would sit in the middle of the messages published meanwhile
+        LOG("BOCOM_LoanQueueSlot", "not available for byte ring queues !");
+        return Invalid;
+    }
+    else
+    {
+        try
+        {
+            //Without an unused buffer the oldest message is dropped now instead of at commit
+            LockTimer timer(context->stats);
+            scoped_lock<interprocess_upgradable_mutex> lock(*context->rwlock);
+            timer.Taken();
+            uint32_t buffer = 0;
+            if (!TakePoolBuffer(context, &buffer))
+            {
+                LOG("BOCOM_LoanQueueSlot", "every buffer is loaned !");
+                return MemLack;
+            }
+            context->loan = PoolBuffer(context, buffer);
+            context->loanPos = buffer;
+        }
+        catch (interprocess_exception &ex)
         {
-            segment->construct<CondPubType>("BOCOM_PRIV_COND_QUEUE")();
+            LOG("LoanQueueSlot", ex.what());
+            return ComError;
         }
     }
-    catch (interprocess_exception &ex)
+    context->loanSize = size;
+    *ptr = context->loan;
+    return Success;
+}
+
+static ErrorCode CommitQueueSlot(QueueContext *context, void *ptr, unsigned int actualLen)
+{
+    if (context == nullptr || context->segment == nullptr)
     {
-        LOG("CreateQueue", ex.what());
-        return nullptr;
+        LOG("BOCOM_CommitQueueSlot", "param is null !");
+        return ComError;
     }
+    if (ptr == nullptr || ptr != context->loan || actualLen > context->loanSize)
+    {
+        LOG("BOCOM_CommitQueueSlot", "slot is not loaned or actualLen is too large !");
+        return Invalid;
+    }
+    context->loan = nullptr;
 
-    LOG("BOCOM_CreateQueue", "SUCCESS!");
+    if (context->queueMode == Spsc)
+    {
+        //Not advancing head is enough to give the slot back
+        if (actualLen > 0)
+        {
+            CommitSpsc(context, RingSlot(context, context->loanPos), context->loanPos, actualLen);
+            NotifyQueueReaders(context);
+            CountQueuePublish(context, Success);
+        }
+        return Success;
+    }
+    if (context->queueMode == Mpmc)
+    {
+        //The claimed slot must be released in order, a zero length one is skipped by the consumers and by DropOldestMpmc
+        CommitMpmc(RingSlot(context, context->loanPos), context->loanPos, actualLen);
+        if (actualLen > 0)
+        {
+            NotifyQueueReaders(context);
+            CountQueuePublish(context, Success);
+        }
+        return Success;
+    }
 
-    return context;
-}
+    try
+    {
+        LockTimer timer(context->stats);
+        scoped_lock<interprocess_upgradable_mutex> lock(*context->rwlock);
+        timer.Taken();
+        const uint32_t buffer = static_cast<uint32_t>(context->loanPos);
+        if (actualLen == 0)
+        {
+            context->poolFree[context->pool->freeCount++] = buffer;
+            return Success;
+        }
+        AppendPoolEntry(context, buffer, actualLen, 0);
 
-static ErrorCode DestroyQueue(QueueContext *context)
-{
-    if (context == nullptr || context->segment == nullptr)
+        lock.unlock();
+        timer.Released();
+        NotifyQueueReaders(context);
+        CountQueuePublish(context, Success);
+    }
+    catch (interprocess_exception &ex)
     {
-        LOG("BOCOM_DestroyQueue", "param is null !");
+        LOG("CommitQueueSlot", ex.what());
         return ComError;
     }
+    return Success;
+}
+
+static ErrorCode ResolveQueue(QueueContext *context)
+{
     managed_shared_memory *segment = context->segment;
 
-    const char *queueName = nullptr;
+    //The queue header is the only named object without the private prefix
     const_named_it named_beg = segment->named_begin();
     const_named_it named_end = segment->named_end();
     for (; named_beg != named_end; ++named_beg)
@@ -402,313 +2776,733 @@ static ErrorCode DestroyQueue(QueueContext *context)
         const managed_shared_memory::char_type *name = named_beg->name();
         if (std::strncmp("BOCOM_PRIV_", name, 10))
         {
-            queueName = name;
+            context->queueName = name;
             break;
         }
     }
-    if (queueName == nullptr)
+    if (context->queueName.empty())
     {
-        LOG("BOCOM_Destroy", "queueName is null");
+        LOG("BOCOM_ResolveQueue", "queueName is null");
         return Invalid;
     }
 
-    BcomDequeType *this_deque = segment->find<BcomDequeType>(queueName).first;
-    while (this_deque->size() > 0)
+    QueueMode *queueMode = segment->find<QueueMode>("BOCOM_PRIV_QUEUE_MODE").first;
+    QueSizeType *queSize = segment->find<QueSizeType>("BOCOM_PRIV_QUEUE_SIZE").first;
+    if (nullptr == queueMode || nullptr == queSize)
     {
-        QueMsgType queItem = this_deque->front();
-        void *shptr = segment->get_address_from_handle(queItem.itemHandle);
-        if (nullptr != shptr)
-        {
-            segment->deallocate(shptr);
-        }
-        this_deque->pop_front();
+        LOG("BOCOM_ResolveQueue", "queue control data is null !");
+        return ComError;
     }
-    segment->destroy<BcomDequeType>(queueName);
+    context->queueMode = *queueMode;
+    context->maxQueueSize = queSize->first;
+    context->maxElementSize = queSize->second;
+    context->readers = segment->find<ReaderFdTable>("BOCOM_PRIV_QUEUE_READERS").first;
+    context->consumers = segment->find<ConsumerTable>("BOCOM_PRIV_QUEUE_CONSUMERS").first;
+
+    context->block = segment->find<QueueBlockType>(context->queueName.c_str()).first;
+    if (nullptr == context->block)
+    {
+        LOG("BOCOM_ResolveQueue", "queue control data is null !");
+        return ComError;
+    }
+    AttachQueue(context);
+    return Success;
+}
 
-    if (segment->find<RwlockType>("BOCOM_PRIV_RWLOCK_QUEUE").first)
+static QueueContext* JoinQueue(const char *queueName)
+{
+    auto *context = new QueueContext;
+    try
     {
-        segment->destroy<RwlockType>("BOCOM_PRIV_RWLOCK_QUEUE");
+        context->segment = new managed_shared_memory(open_only, queueName);
+        if (Success != ResolveQueue(context))
+        {
+            delete context->segment;
+            delete context;
+            return nullptr;
+        }
+        const int *memoryFlags = context->segment->find<int>("BOCOM_PRIV_MEMORY_FLAGS").first;
+        if (nullptr != memoryFlags)
+        {
+            ApplyMemoryFlags(context->segment, *memoryFlags);
+        }
     }
-    if (segment->find<CondPubType>("BOCOM_PRIV_COND_QUEUE").first)
+    catch (interprocess_exception &ex)
     {
-        segment->destroy<CondPubType>("BOCOM_PRIV_COND_QUEUE");
+        LOG("JoinQueue", ex.what());
+        delete context->segment;
+        delete context;
+        return nullptr;
     }
 
-    shared_memory_object::remove(queueName);
+    LOG("BOCOM_JoinQueue", "SUCCESS!");
+
+    return context;
+}
 
+static ErrorCode QuitQueue(QueueContext *context)
+{
+    if (context->readerFd >= 0)
+    {
+        UnregisterReaderFd(context->readers, context->readerSlot, context->readerFd);
+    }
+    if (context->timedReader)
+    {
+        context->notify->timedReaders.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (nullptr != context->consumer)
+    {
+        context->consumer->pid.store(0);
+        context->consumer->state.store(0);
+    }
     if (nullptr != context->segment)
     {
         delete context->segment;
         context->segment = nullptr;
     }
+    else
+    {
+        LOG("BOCOM_QuitQueue", "segment is null !");
+        return ComError;
+    }
+
     if (nullptr != context)
     {
         delete context;
         context = nullptr;
     }
+    else
+    {
+        LOG("BOCOM_QuitQueue", "context is null !");
+        return ComError;
+    }
     return Success;
 }
 
-static ErrorCode PublishQueue(QueueContext *context, const void *value, unsigned int valueLength)
+//Find the next message of this consumer, the caller holds the queue lock.
+//The queued messages are tail..head - 1, message i is entry i & mask
+static ErrorCode NextPoolEntry(QueueContext *context, const PoolEntryType **entry)
 {
-    if (context == nullptr || value == nullptr || context->segment == nullptr)
+    const PoolQueueType *pool = context->pool;
+
+    if (pool->head == pool->tail)
     {
-        LOG("BOCOM_Publish", "param is null !");
+        return NoData;
+    }
+
+    //Set the initial value at the first call
+    if (context->index == 0)
+    {
+        context->index = pool->tail;
+    }
+    //Overwritten before it was read: continue with the oldest message
+    if (context->index < pool->tail)
+    {
+        *entry = PoolEntry(context, pool->tail);
+        context->index = pool->tail + 1;
+        return DataLost;
+    }
+    //Caught up with the publishers
+    if (context->index >= pool->head)
+    {
+        return NoData;
+    }
+
+    *entry = PoolEntry(context, context->index);
+    context->index++;
+    return Success;
+}
+
+//Notify mode: only sleep while caught up. seq is read under the queue lock, so a publish after
+//the unlock changes it and the futex wait returns at once instead of missing the wakeup
+static ErrorCode WaitPoolEntry(QueueContext *context, sharable_lock<interprocess_upgradable_mutex> &lock, LockTimer &timer,
+                               const PoolEntryType **entry, const DeadlineType *deadline)
+{
+    NotifyType *notify = (context->queueMode == Notify) ? context->notify : nullptr;
+    for (;;)
+    {
+        const uint32_t seq = (nullptr != notify) ? notify->seq.load(std::memory_order_relaxed) : 0;
+        const ErrorCode ret = NextPoolEntry(context, entry);
+        if (ret != NoData || nullptr == notify)
+        {
+            return ret;
+        }
+
+        lock.unlock();
+        timer.Released();
+        notify->waiters.fetch_add(1);
+        const bool waited = FutexWait(&notify->seq, seq, deadline);
+        notify->waiters.fetch_sub(1, std::memory_order_relaxed);
+        if (!waited)
+        {
+            return Timeout;
+        }
+        //A writer or a peek can hold the lock past the deadline of a timed retrieve
+        timer.Waiting();
+        if (!TakeLock(lock, 1, deadline))
+        {
+            return Timeout;
+        }
+        timer.Taken();
+    }
+}
+
+//deadline: only for Notify queues, nullptr sleeps until the next publish
+static ErrorCode RetrieveQueueMessage(QueueContext* context, const struct iovec *iov, int iovcnt, unsigned int *valueLength,
+                                      const DeadlineType *deadline)
+{
+    if (context == nullptr || iov == nullptr || iovcnt < 0 || context->segment == nullptr)
+    {
+        LOG("BOCOM_Retrieve", "param is null !");
         return ComError;
     }
-    managed_shared_memory *segment = context->segment;
 
+    if (context->queueMode == Spsc)
+    {
+        return RetrieveSpsc(context, iov, iovcnt, valueLength);
+    }
+    if (context->queueMode == Mpmc)
+    {
+        return RetrieveMpmc(context, iov, iovcnt, valueLength);
+    }
     try
     {
-        const char* queueName = nullptr;
+        LockTimer timer(context->stats);
+        sharable_lock<interprocess_upgradable_mutex> lock(*context->rwlock, defer_lock);
+        if (!TakeLock(lock, 1, deadline))
+        {
+            return Timeout;
+        }
+        timer.Taken();
+
+        const PoolEntryType *entry = nullptr;
+        const ErrorCode ret = WaitPoolEntry(context, lock, timer, &entry, deadline);
+        if (nullptr == entry)
+        {
+            return ret;
+        }
+
+        const unsigned int msgLen = entry->length;
+        ScatterIov(iov, iovcnt, PoolBuffer(context, entry->buffer), msgLen);
+        if(NULL != valueLength)
+        {
+            *valueLength = msgLen;
+        }
+        return ret;
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("RetrieveQueue", ex.what());
+        return ComError;
+    }
+    return Success;
+}
+
+//With a readiness descriptor, arm it before reporting that nothing is there and look once more
+static bool RearmQueueFd(QueueContext *context, ErrorCode ret)
+{
+    if (context->readerFd < 0 || (ret != NoData && ret != Timeout))
+    {
+        return false;
+    }
+    ArmReaderFd(context->readers, context->readerSlot, context->readerFd);
+    return true;
+}
+
+static ErrorCode RetrieveQueueOnce(QueueContext* context, const struct iovec *iov, int iovcnt, unsigned int *valueLength,
+                                   const DeadlineType *deadline)
+{
+    ErrorCode ret = RetrieveQueueMessage(context, iov, iovcnt, valueLength, deadline);
+    if (context != nullptr && RearmQueueFd(context, ret))
+    {
+        ret = RetrieveQueueMessage(context, iov, iovcnt, valueLength, deadline);
+    }
+    return ret;
+}
+
+static ErrorCode RetrieveQueueV(QueueContext* context, const struct iovec *iov, int iovcnt, unsigned int *valueLength)
+{
+    const ErrorCode ret = RetrieveQueueOnce(context, iov, iovcnt, valueLength, nullptr);
+    if (context != nullptr && context->segment != nullptr)
+    {
+        CountQueueRetrieve(context, ret);
+    }
+    return ret;
+}
+
+//The single buffer calls expect room for maxElementSize bytes
+static ErrorCode RetrieveQueue(QueueContext* context, void *outputValue, unsigned int *valueLength)
+{
+    if (context == nullptr || outputValue == nullptr)
+    {
+        LOG("BOCOM_Retrieve", "param is null !");
+        return ComError;
+    }
+    const struct iovec iov = {outputValue, context->maxElementSize};
+    return RetrieveQueueV(context, &iov, 1, valueLength);
+}
+
+//Notify queues sleep in RetrieveQueueOnce. The other modes sleep on the same futex word, which their
+//publishers bump once a context of the queue counted itself in timedReaders
+static ErrorCode RetrieveQueueTimed(QueueContext *context, void *outputValue, unsigned int *valueLength, int timeoutMs)
+{
+    if (context == nullptr || timeoutMs < 0)
+    {
+        LOG("BOCOM_RetrieveQueueTimed", "param is illegal !");
+        return Invalid;
+    }
+    if (outputValue == nullptr || context->segment == nullptr)
+    {
+        LOG("BOCOM_Retrieve", "param is null !");
+        return ComError;
+    }
+
+    NotifyType *notify = context->notify;
+    if (context->queueMode != Notify && !context->timedReader)
+    {
+        notify->timedReaders.fetch_add(1);
+        SyncPublishers();
+        context->timedReader = true;
+    }
+
+    //Counted once for the whole wait. seq is read before looking, a publish after the look changes it
+    const struct iovec iov = {outputValue, context->maxElementSize};
+    const DeadlineType deadline = DeadlineAfter(timeoutMs);
+    ErrorCode ret = NoData;
+    for (;;)
+    {
+        const uint32_t seen = notify->seq.load();
+        ret = RetrieveQueueOnce(context, &iov, 1, valueLength, &deadline);
+        if (ret != NoData)
+        {
+            break;
+        }
+        if (!WaitPublished(notify, seen, &deadline))
+        {
+            ret = Timeout;
+            break;
+        }
+    }
+    CountQueueRetrieve(context, ret);
+    return ret;
+}
 
-        const_named_it named_beg = segment->named_begin();
-        const_named_it named_end = segment->named_end();
-        for (; named_beg != named_end; ++named_beg)
+//Copy up to maxCount messages, the queue is locked once and the messages after the first one are contiguous
+static ErrorCode RetrieveQueueBatchOnce(QueueContext *context, void **bufs, unsigned int *lens, int maxCount, int *got, uint64_t *lost)
+{
+    *got = 0;
+    *lost = 0;
+    if (context->queueMode == Spsc)
+    {
+        for (; *got < maxCount; (*got)++)
         {
-            //A pointer to the name of the named object
-            const managed_shared_memory::char_type *name = named_beg->name();
-            if (std::strncmp("BOCOM_PRIV_", name,10))
+            const uint64_t expected = context->index;
+            const struct iovec iov = {bufs[*got], context->maxElementSize};
+            const ErrorCode ret = RetrieveSpsc(context, &iov, 1, &lens[*got]);
+            if (ret == NoData)
             {
-                queueName = name;
                 break;
             }
+            if (ret == DataLost)
+            {
+                *lost += context->index - 1 - expected;
+            }
         }
-        if(queueName == nullptr)
+        return Success;
+    }
+    if (context->queueMode == Mpmc)
+    {
+        for (; *got < maxCount; (*got)++)
         {
-            LOG("BOCOM_Publish", "queueName is null");
-            return Invalid;
+            uint64_t pos = 0;
+            RingSlotType *slot = ClaimReadMpmc(context, &pos);
+            if (nullptr == slot)
+            {
+                break;
+            }
+            const uint32_t msgLen = static_cast<uint32_t>(std::min<uint64_t>(slot->length, context->maxElementSize));
+            std::memcpy(bufs[*got], RingPayload(slot), msgLen);
+            lens[*got] = msgLen;
+            uint64_t dropped = 0;
+            ReleaseReadMpmc(context, slot, pos, &dropped);
+            *lost += dropped;
         }
+        return Success;
+    }
 
-        RwlockType *rwlock = segment->find<RwlockType>("BOCOM_PRIV_RWLOCK_QUEUE").first;
-        if (nullptr == rwlock)
+    try
+    {
+        LockTimer timer(context->stats);
+        sharable_lock<interprocess_upgradable_mutex> lock(*context->rwlock);
+        timer.Taken();
+
+        const uint64_t expected = context->index;
+        const PoolEntryType *entry = nullptr;
+        const ErrorCode ret = WaitPoolEntry(context, lock, timer, &entry, nullptr);
+        if (nullptr == entry)
         {
-            LOG("BOCOM_Publish", "data is nullptr !");
-            return ComError;
+            return (ret == NoData) ? Success : ret;
+        }
+        if (ret == DataLost)
+        {
+            *lost = entry->index - expected;
         }
-        scoped_lock<interprocess_upgradable_mutex> lock(*rwlock);
 
-        BcomDequeType *this_deque = segment->find<BcomDequeType>(queueName).first;
+        for (uint64_t index = entry->index; index < context->pool->head && *got < maxCount; index++, (*got)++)
+        {
+            const PoolEntryType *next = PoolEntry(context, index);
+            std::memcpy(bufs[*got], PoolBuffer(context, next->buffer), next->length);
+            lens[*got] = next->length;
+            context->index = index + 1;
+        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("RetrieveQueueBatch", ex.what());
+        return ComError;
+    }
+    return Success;
+}
+
+static ErrorCode RetrieveQueueBatch(QueueContext *context, void **bufs, unsigned int *lens, int maxCount, int *got, unsigned int *lost)
+{
+    if (context == nullptr || bufs == nullptr || lens == nullptr || got == nullptr || context->segment == nullptr)
+    {
+        LOG("BOCOM_RetrieveQueueBatch", "param is null !");
+        return ComError;
+    }
+    if (maxCount <= 0)
+    {
+        LOG("BOCOM_RetrieveQueueBatch", "maxCount is illegal !");
+        return Invalid;
+    }
+
+    uint64_t dropped = 0;
+    ErrorCode ret = RetrieveQueueBatchOnce(context, bufs, lens, maxCount, got, &dropped);
+    if (ret == Success && 0 == *got && RearmQueueFd(context, NoData))
+    {
+        ret = RetrieveQueueBatchOnce(context, bufs, lens, maxCount, got, &dropped);
+    }
+    if (nullptr != lost)
+    {
+        *lost = static_cast<unsigned int>(std::min<uint64_t>(dropped, UINT_MAX));
+    }
+    if (ret == Success)
+    {
+        ret = (0 == *got) ? NoData : ((0 != dropped) ? DataLost : Success);
+    }
+    CountQueueRetrieve(context, ret, *got);
+    return ret;
+}
+
+static ErrorCode PeekQueueMessage(QueueContext *context, const void **ptr, unsigned int *valueLength, unsigned long long *token)
+{
+    if (context == nullptr || ptr == nullptr || valueLength == nullptr || token == nullptr || context->segment == nullptr)
+    {
+        LOG("BOCOM_PeekQueue", "param is null !");
+        return ComError;
+    }
+    if (context->peeking)
+    {
+        LOG("BOCOM_PeekQueue", "a message is peeked already !");
+        return Invalid;
+    }
 
-        uint32_t maxQueueSize = segment->find<QueSizeType>("BOCOM_PRIV_QUEUE_SIZE").first->first;
-        uint32_t maxElementSize = segment->find<QueSizeType>("BOCOM_PRIV_QUEUE_SIZE").first->second;
-        if(valueLength > maxElementSize)
+    ErrorCode ret = Success;
+    if (context->queueMode == Spsc)
+    {
+        ret = PeekSpsc(context, ptr, valueLength);
+    }
+    else if (context->queueMode == Mpmc)
+    {
+        RingSlotType *slot = ClaimReadMpmc(context, &context->peekToken);
+        if (nullptr == slot)
         {
-            LOG("BOCOM_Publish", "valueLength is larger than maxElementSize !");
-            return Invalid;
+            return NoData;
         }
-        void *shptr = NULL;
-        if (this_deque->size() < maxQueueSize)
+        *ptr = RingPayload(slot);
+        *valueLength = static_cast<uint32_t>(std::min<uint64_t>(slot->length, context->maxElementSize));
+        if (0 != TakeLostMpmc(context->ring))
         {
-            shptr = AllocInShmem(segment, maxElementSize);
-            if (shptr == nullptr)
-            {
-                LOG("BOCOM_Publish", "data alloc shptr is nullptr !");
-                return ComError;
-            }
+            ret = DataLost;
         }
-        else
+    }
+    else
+    {
+        try
         {
-            QueMsgType queItem = this_deque->front();
-            shptr = segment->get_address_from_handle(queItem.itemHandle);
-            if (nullptr == shptr)
-            {
-                LOG("BOCOM_Publish", "data shptr is nullptr !");
-                return ComError;
-            }
-            if (queItem.itemLength > 0)
+            LockTimer timer(context->stats);
+            sharable_lock<interprocess_upgradable_mutex> lock(*context->rwlock);
+            timer.Taken();
+
+            const PoolEntryType *entry = nullptr;
+            ret = WaitPoolEntry(context, lock, timer, &entry, nullptr);
+            if (nullptr == entry)
             {
-                std::memset(shptr,0,queItem.itemLength);
+                return ret;
             }
-            this_deque->pop_front();
-        }
-        if (valueLength > 0 && shptr != nullptr)
-        {
-            std::memcpy(shptr, value, valueLength);
+            *ptr = PoolBuffer(context, entry->buffer);
+            *valueLength = entry->length;
+            context->peekToken = entry->index;
+            //Keep the sharable lock until ReleaseQueue, publishers cannot recycle the message meanwhile
+            lock.release();
+            context->peekTime = timer.Detach();
         }
-        else
+        catch (interprocess_exception &ex)
         {
-            LOG("BOCOM_Publish", "copy value failed !");
+            LOG("PeekQueue", ex.what());
             return ComError;
         }
-        managed_shared_memory::handle_t handle = segment->get_handle_from_address(shptr);
-        QueMsgType tmpQueMsg = {
-            .itemHandle = handle,
-            .itemLength = valueLength,
-            .itemIndex = (*(segment->find<uint64_t>("BOCOM_PRIV_QUEUE_INDEX").first))++};
-        this_deque->push_back(tmpQueMsg);
-
-        CondPubType *cond_pub = segment->find<CondPubType>("BOCOM_PRIV_COND_QUEUE").first;
-        if(nullptr != cond_pub)
-        {
-            cond_pub->notify_all();
-        }
     }
-    catch (interprocess_exception &ex)
+    if (ret == Success || ret == DataLost)
     {
-        LOG("PublishQueue", ex.what());
-        return ComError;
+        context->peeking = true;
+        *token = context->peekToken;
     }
-    return Success;
+    return ret;
 }
 
-static QueueContext* JoinQueue(const char *queueName)
+static ErrorCode PeekQueue(QueueContext *context, const void **ptr, unsigned int *valueLength, unsigned long long *token)
 {
-    auto *context = new QueueContext;
-    try
+    ErrorCode ret = PeekQueueMessage(context, ptr, valueLength, token);
+    if (context != nullptr && RearmQueueFd(context, ret))
     {
-        context->segment = new managed_shared_memory(open_only, queueName);
+        ret = PeekQueueMessage(context, ptr, valueLength, token);
     }
-    catch (interprocess_exception &ex)
+    if (context != nullptr && context->segment != nullptr)
     {
-        LOG("JoinQueue", ex.what());
-        return nullptr;
+        CountQueueRetrieve(context, ret);
     }
+    return ret;
+}
 
-    LOG("BOCOM_JoinQueue", "SUCCESS!");
-
-    return context;
+static int GetQueueFd(QueueContext *context)
+{
+    if (context == nullptr || context->readers == nullptr)
+    {
+        LOG("BOCOM_GetQueueFd", "param is null !");
+        return -1;
+    }
+    if (context->readerFd < 0)
+    {
+        context->readerFd = RegisterReaderFd(context->readers, &context->readerSlot);
+    }
+    return context->readerFd;
 }
 
-static ErrorCode QuitQueue(QueueContext *context)
+static int GetQueueNode(QueueContext *context)
 {
-    if (nullptr != context->segment)
+    if (context == nullptr || context->segment == nullptr)
     {
-        delete context->segment;
-        context->segment = nullptr;
+        LOG("BOCOM_GetQueueNode", "param is null !");
+        return -1;
     }
-    else
+    return SegmentNode(IsRingMode(context->queueMode) ? context->ringSlots : context->poolBuffers);
+}
+
+static ErrorCode GetQueueStats(QueueContext *context, st_STATS_INFO *stats)
+{
+    if (context == nullptr || stats == nullptr || context->segment == nullptr)
     {
-        LOG("BOCOM_QuitQueue", "segment is null !");
+        LOG("BOCOM_GetQueueStats", "param is null !");
         return ComError;
     }
-
-    if (nullptr != context)
+    ReadStats(context->stats, stats);
+    //Read without the lock, the two indexes may be a publish apart
+    if (IsRingMode(context->queueMode))
     {
-        delete context;
-        context = nullptr;
+        const uint64_t tail = context->ring->tail.load(std::memory_order_relaxed);
+        const uint64_t head = context->ring->head.load(std::memory_order_relaxed);
+        stats->depth = (head > tail) ? std::min<uint64_t>(head - tail, context->maxQueueSize) : 0;
     }
     else
     {
-        LOG("BOCOM_QuitQueue", "context is null !");
-        return ComError;
+        const uint64_t tail = __atomic_load_n(&context->pool->tail, __ATOMIC_RELAXED);
+        const uint64_t head = __atomic_load_n(&context->pool->head, __ATOMIC_RELAXED);
+        stats->depth = (head > tail) ? head - tail : 0;
     }
     return Success;
 }
 
-static ErrorCode RetrieveQueue(QueueContext* context, void *outputValue, unsigned int *valueLength)
+static ErrorCode ReleaseQueue(QueueContext *context, unsigned long long token)
 {
-    if (context == nullptr || outputValue == nullptr || context->segment == nullptr)
+    if (context == nullptr || context->segment == nullptr)
     {
-        LOG("BOCOM_Retrieve", "param is null !");
+        LOG("BOCOM_ReleaseQueue", "param is null !");
         return ComError;
     }
+    if (!context->peeking || token != context->peekToken)
+    {
+        LOG("BOCOM_ReleaseQueue", "token is not peeked !");
+        return Invalid;
+    }
+    context->peeking = false;
 
-    managed_shared_memory *segment = context->segment;
+    if (context->queueMode == Spsc)
+    {
+        ReleaseSpsc(context);
+        return Success;
+    }
+    if (context->queueMode == Mpmc)
+    {
+        //Drops were reported by the peek already
+        RingSlotType *slot = RingSlot(context, context->peekToken);
+        slot->seq.store(context->peekToken + context->ring->mask + 1, std::memory_order_release);
+        return Success;
+    }
+    context->rwlock->unlock_sharable();
+    RecordLockHold(context->stats, context->peekTime);
+    return Success;
+}
 
+static InspectContext *AttachInspect(const char *name)
+{
+    if (name == nullptr)
+    {
+        LOG("BOCOM_AttachInspect", "param is null !");
+        return nullptr;
+    }
+    auto *inspCtx = new InspectContext;
     try
     {
-        const char* queueName = nullptr;
-
-        const_named_it named_beg = segment->named_begin();
-        const_named_it named_end = segment->named_end();
-        for (; named_beg != named_end; ++named_beg)
+        inspCtx->segment = new managed_shared_memory(open_read_only, name);
+        if (nullptr != inspCtx->segment->find<QueueMode>("BOCOM_PRIV_QUEUE_MODE").first)
         {
-            //A pointer to the name of the named object
-            const managed_shared_memory::char_type *name = named_beg->name();
-            if (std::strncmp("BOCOM_PRIV_", name,10))
+            inspCtx->queue = new QueueContext;
+            inspCtx->queue->segment = inspCtx->segment;
+            if (Success != ResolveQueue(inspCtx->queue))
             {
-                queueName = name;
-                break;
+                delete inspCtx->queue;
+                delete inspCtx->segment;
+                delete inspCtx;
+                return nullptr;
             }
         }
-        if(queueName == nullptr)
-        {
-            LOG("BOCOM_Publish", "queueName is null");
-            return Invalid;
-        }
+    }
+    catch (interprocess_exception &ex)
+    {
+        LOG("AttachInspect", ex.what());
+        delete inspCtx->queue;
+        delete inspCtx->segment;
+        delete inspCtx;
+        return nullptr;
+    }
+    return inspCtx;
+}
 
-        RwlockType *rwlock = segment->find<RwlockType>("BOCOM_PRIV_RWLOCK_QUEUE").first;
-        if (nullptr == rwlock)
-        {
-            LOG("BOCOM_Retrieve", "data is null !");
-            return ComError;
-        }
-        sharable_lock<interprocess_upgradable_mutex> lock(*rwlock);
+static ErrorCode DetachInspect(InspectContext *inspCtx)
+{
+    if (inspCtx == nullptr)
+    {
+        LOG("BOCOM_DetachInspect", "param is null !");
+        return ComError;
+    }
+    delete inspCtx->queue;
+    delete inspCtx->segment;
+    delete inspCtx;
+    return Success;
+}
 
-        CondPubType *cond_pub = segment->find<CondPubType>("BOCOM_PRIV_COND_QUEUE").first;
-        if(nullptr != cond_pub)
-        {
-            cond_pub->wait(lock);
-        }
+static void FillEntry(st_ENTRY_INFO *entry, const char *name, int elementSize, int mode, int capacity)
+{
+    std::memset(entry, 0, sizeof(*entry));
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    entry->elementSize = elementSize;
+    entry->mode = mode;
+    entry->capacity = capacity;
+}
 
-        BcomDequeType *this_deque = segment->find<BcomDequeType>(queueName).first;
+//Objects constructed or destroyed meanwhile may be missed, the segment index is read without its lock
+static ErrorCode InspectSegment(InspectContext *inspCtx, st_SEGMENT_INFO *info, st_ENTRY_INFO *entries, int maxCount, int *count)
+{
+    if (inspCtx == nullptr || info == nullptr || count == nullptr || (entries == nullptr && maxCount > 0))
+    {
+        LOG("BOCOM_InspectSegment", "param is null !");
+        return ComError;
+    }
+    managed_shared_memory *segment = inspCtx->segment;
+    std::memset(info, 0, sizeof(*info));
+    info->size = segment->get_size();
+    info->freeMemory = segment->get_free_memory();
+    *count = 0;
 
-        if(this_deque->empty())
-        {
-            return NoData;
-        }
-        
-        QueMsgType queItem = this_deque->front();
-        //Set the initial value at the first call
-        if (context->index == 0)
+    if (nullptr != inspCtx->queue)
+    {
+        QueueContext *queue = inspCtx->queue;
+        info->isQueue = 1;
+        info->entries = 1;
+        if (maxCount > 0)
         {
-            context->index = queItem.itemIndex;
+            FillEntry(&entries[0], queue->queueName.c_str(), queue->maxElementSize, queue->queueMode, queue->maxQueueSize);
+            GetQueueStats(queue, &entries[0].stats);
+            *count = 1;
         }
-        //If the last traversal to the end of the queue returns no data
-        if ((context->index > queItem.itemIndex) && (context->index - queItem.itemIndex >= this_deque->size()))
+        return Success;
+    }
+
+    const_named_it named_beg = segment->named_begin();
+    const_named_it named_end = segment->named_end();
+    for (; named_beg != named_end; ++named_beg)
+    {
+        const managed_shared_memory::char_type *name = named_beg->name();
+        if (0 == std::strncmp("BOCOM_PRIV_", name, 11))
         {
-            return NoData;
+            continue;
         }
-
-        for (BcomDequeType::iterator itor = this_deque->begin(); itor != this_deque->end(); ++itor)
+        info->entries++;
+        const BcomMsgType *msg = static_cast<const BcomMsgType *>(named_beg->value());
+        if (*count >= maxCount)
         {
-            if (itor->itemIndex == context->index)
-            {
-                //normal
-                void *msg = segment->get_address_from_handle(itor->itemHandle);
-                const int msgLen = itor->itemLength;
-                if(msgLen > 0)
-                {
-                    std::memcpy(outputValue, msg, msgLen);
-                }
-                if(NULL != valueLength)
-                {
-                    *valueLength = msgLen;
-                }
-
-                context->index++;
-                return Success;
-            }
-            else if (itor->itemIndex < context->index)
-            {
-                //retreive faster
-                continue;
-            }
-            else
-            {
-                //retreive slower
-                void *msg = segment->get_address_from_handle(itor->itemHandle);
-                const int msgLen = itor->itemLength;
-                if(msgLen > 0)
-                {
-                    std::memcpy(outputValue, msg, msgLen);
-                }
-                if(NULL != valueLength)
-                {
-                    *valueLength = msgLen;
-                }
-
-                context->index = itor->itemIndex + 1;
-                return DataLost;
-            }
+            continue;
         }
+        st_ENTRY_INFO *entry = &entries[(*count)++];
+        FillEntry(entry, name, msg->size, msg->mode, msg->slotCount);
+        ReadStats(static_cast<const StatsType *>(segment->get_address_from_handle(msg->stats)), &entry->stats);
     }
-    catch (interprocess_exception &ex)
+    return Success;
+}
+
+//Lag: messages queued that the consumer has not retrieved yet. Mpmc consumers share the messages, each one lags the depth
+static ErrorCode InspectConsumers(InspectContext *inspCtx, st_CONSUMER_INFO *consumers, int maxCount, int *count)
+{
+    if (inspCtx == nullptr || consumers == nullptr || count == nullptr)
     {
-        LOG("RetrieveQueue", ex.what());
+        LOG("BOCOM_InspectConsumers", "param is null !");
         return ComError;
     }
+    *count = 0;
+    QueueContext *queue = inspCtx->queue;
+    if (nullptr == queue)
+    {
+        LOG("BOCOM_InspectConsumers", "not a queue !");
+        return Invalid;
+    }
+    if (nullptr == queue->consumers)
+    {
+        return Success;
+    }
+
+    st_STATS_INFO stats;
+    GetQueueStats(queue, &stats);
+    const uint64_t head = IsRingMode(queue->queueMode) ? queue->ring->head.load(std::memory_order_relaxed)
+                                                       : __atomic_load_n(&queue->pool->head, __ATOMIC_RELAXED);
+    for (const auto &consumer : queue->consumers->consumers)
+    {
+        const uint32_t pid = consumer.pid.load(std::memory_order_relaxed);
+        if (0 == consumer.state.load(std::memory_order_relaxed) || 0 == pid || *count >= maxCount)
+        {
+            continue;
+        }
+        const uint64_t index = consumer.index.load(std::memory_order_relaxed);
+        st_CONSUMER_INFO *info = &consumers[(*count)++];
+        info->pid = static_cast<int>(pid);
+        info->lag = stats.depth;
+        //A consumer behind the oldest queued message lost some and still has every queued one to read
+        if (queue->queueMode != Mpmc && 0 != index && head - index < stats.depth)
+        {
+            info->lag = head - index;
+        }
+    }
     return Success;
 }
 
@@ -742,6 +3536,56 @@ ErrorCode BOCOM_Publish(Context chnCtx, char *objectName, void *value, int value
     return Publish(chnCtx, objectName, value, valueLength, flags);
 }
 
+Context BOCOM_OpenObject(Context chnCtx, char *objectName)
+{
+    return static_cast<Context>(OpenObject(chnCtx, objectName));
+}
+
+ErrorCode BOCOM_CloseObject(Context objCtx)
+{
+    return CloseObject(static_cast<ObjectContext *>(objCtx));
+}
+
+ErrorCode BOCOM_PublishObject(Context objCtx, void *value, int valueLength, int flags)
+{
+    return PublishObject(static_cast<ObjectContext *>(objCtx), value, valueLength, flags);
+}
+
+ErrorCode BOCOM_PublishObjectV(Context objCtx, const struct iovec *iov, int iovcnt, int flags)
+{
+    return PublishObjectV(static_cast<ObjectContext *>(objCtx), iov, iovcnt, flags);
+}
+
+ErrorCode BOCOM_AcquireObjectWrite(Context objCtx, void **ptr, int flags)
+{
+    return AcquireObjectWrite(static_cast<ObjectContext *>(objCtx), ptr, flags);
+}
+
+ErrorCode BOCOM_AcquireObjectRead(Context objCtx, const void **ptr, int flags)
+{
+    return AcquireObjectRead(static_cast<ObjectContext *>(objCtx), ptr, flags);
+}
+
+ErrorCode BOCOM_ReleaseObject(Context objCtx)
+{
+    return ReleaseObject(static_cast<ObjectContext *>(objCtx));
+}
+
+int BOCOM_GetObjectFd(Context objCtx)
+{
+    return GetObjectFd(static_cast<ObjectContext *>(objCtx));
+}
+
+int BOCOM_GetObjectNode(Context objCtx)
+{
+    return GetObjectNode(static_cast<ObjectContext *>(objCtx));
+}
+
+ErrorCode BOCOM_GetObjectStats(Context objCtx, st_STATS_INFO *stats)
+{
+    return GetObjectStats(static_cast<ObjectContext *>(objCtx), stats);
+}
+
 Context BOCOM_JoinChannel(char *channelName)
 {
     return JoinChannel(channelName);
@@ -752,6 +3596,38 @@ ErrorCode BOCOM_Retrieve(Context chnCtx, char *objectName, void *outPutValue, in
     return Retrieve(chnCtx, objectName, outPutValue, valueLength, flags);
 }
 
+ErrorCode BOCOM_RetrieveTimed(Context chnCtx, char *objectName, void *outPutValue, int valueLength, int flags, int timeoutMs)
+{
+    if (timeoutMs < 0)
+    {
+        LOG("BOCOM_RetrieveTimed", "timeout is illegal !");
+        return Invalid;
+    }
+    const DeadlineType deadline = DeadlineAfter(timeoutMs);
+    return Retrieve(chnCtx, objectName, outPutValue, valueLength, flags, &deadline);
+}
+
+ErrorCode BOCOM_RetrieveObject(Context objCtx, void *outPutValue, int valueLength, int flags)
+{
+    return RetrieveObject(static_cast<ObjectContext *>(objCtx), outPutValue, valueLength, flags);
+}
+
+ErrorCode BOCOM_RetrieveObjectV(Context objCtx, const struct iovec *iov, int iovcnt, int flags)
+{
+    return RetrieveObjectV(static_cast<ObjectContext *>(objCtx), iov, iovcnt, flags);
+}
+
+ErrorCode BOCOM_RetrieveObjectTimed(Context objCtx, void *outPutValue, int valueLength, int flags, int timeoutMs)
+{
+    if (timeoutMs < 0)
+    {
+        LOG("BOCOM_RetrieveObjectTimed", "timeout is illegal !");
+        return Invalid;
+    }
+    const DeadlineType deadline = DeadlineAfter(timeoutMs);
+    return RetrieveObject(static_cast<ObjectContext *>(objCtx), outPutValue, valueLength, flags, &deadline);
+}
+
 Context BOCOM_CreateQueue(const st_QUEUE_INFO *info)
 {
     return static_cast<Context>(CreateQueue(info));
@@ -767,6 +3643,16 @@ ErrorCode BOCOM_PublishQueue(Context context, const void *value, unsigned int va
     return PublishQueue(static_cast<QueueContext*>(context), value, valueLength);
 }
 
+ErrorCode BOCOM_PublishQueueV(Context context, const struct iovec *iov, int iovcnt)
+{
+    return PublishQueueV(static_cast<QueueContext*>(context), iov, iovcnt);
+}
+
+ErrorCode BOCOM_PublishQueueBatch(Context context, const struct iovec *msgs, int count)
+{
+    return PublishQueueBatch(static_cast<QueueContext*>(context), msgs, count);
+}
+
 Context BOCOM_JoinQueue(const char *queueName)
 {
     return static_cast<Context>(JoinQueue(queueName));
@@ -782,6 +3668,76 @@ ErrorCode BOCOM_RetrieveQueue(Context context, void *outputValue, unsigned int *
     return RetrieveQueue(static_cast<QueueContext*>(context), outputValue, valueLength);
 }
 
+ErrorCode BOCOM_RetrieveQueueV(Context context, const struct iovec *iov, int iovcnt, unsigned int *valueLength)
+{
+    return RetrieveQueueV(static_cast<QueueContext*>(context), iov, iovcnt, valueLength);
+}
+
+ErrorCode BOCOM_RetrieveQueueTimed(Context context, void *outputValue, unsigned int *valueLength, int timeoutMs)
+{
+    return RetrieveQueueTimed(static_cast<QueueContext*>(context), outputValue, valueLength, timeoutMs);
+}
+
+ErrorCode BOCOM_RetrieveQueueBatch(Context context, void **bufs, unsigned int *lens, int maxCount, int *got, unsigned int *lost)
+{
+    return RetrieveQueueBatch(static_cast<QueueContext*>(context), bufs, lens, maxCount, got, lost);
+}
+
+ErrorCode BOCOM_PeekQueue(Context context, const void **ptr, unsigned int *valueLength, unsigned long long *token)
+{
+    return PeekQueue(static_cast<QueueContext*>(context), ptr, valueLength, token);
+}
+
+ErrorCode BOCOM_ReleaseQueue(Context context, unsigned long long token)
+{
+    return ReleaseQueue(static_cast<QueueContext*>(context), token);
+}
+
+int BOCOM_GetQueueFd(Context context)
+{
+    return GetQueueFd(static_cast<QueueContext*>(context));
+}
+
+int BOCOM_GetQueueNode(Context context)
+{
+    return GetQueueNode(static_cast<QueueContext*>(context));
+}
+
+ErrorCode BOCOM_GetQueueStats(Context context, st_STATS_INFO *stats)
+{
+    return GetQueueStats(static_cast<QueueContext*>(context), stats);
+}
+
+ErrorCode BOCOM_LoanQueueSlot(Context context, unsigned int size, void **ptr)
+{
+    return LoanQueueSlot(static_cast<QueueContext*>(context), size, ptr);
+}
+
+ErrorCode BOCOM_CommitQueueSlot(Context context, void *ptr, unsigned int actualLen)
+{
+    return CommitQueueSlot(static_cast<QueueContext*>(context), ptr, actualLen);
+}
+
+Context BOCOM_AttachInspect(const char *name)
+{
+    return static_cast<Context>(AttachInspect(name));
+}
+
+ErrorCode BOCOM_DetachInspect(Context inspCtx)
+{
+    return DetachInspect(static_cast<InspectContext *>(inspCtx));
+}
+
+ErrorCode BOCOM_InspectSegment(Context inspCtx, st_SEGMENT_INFO *info, st_ENTRY_INFO *entries, int maxCount, int *count)
+{
+    return InspectSegment(static_cast<InspectContext *>(inspCtx), info, entries, maxCount, count);
+}
+
+ErrorCode BOCOM_InspectConsumers(Context inspCtx, st_CONSUMER_INFO *consumers, int maxCount, int *count)
+{
+    return InspectConsumers(static_cast<InspectContext *>(inspCtx), consumers, maxCount, count);
+}
+
 #ifdef __cplusplus
 };
 #endif
@@ -12,31 +12,69 @@
  * |------------------------|
  */
 
+#include <sys/uio.h>
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+typedef enum MemoryFlags {
+    MemHugePages = 1,   //transparent huge pages, where the /dev/shm mount allows them (huge=advise or always)
+    MemPrefault  = 2,   //fault the whole segment in when creating or joining, no page faults afterwards
+    MemLock      = 4,   //prefault and mlock the segment (RLIMIT_MEMLOCK must cover it)
+    MemNumaBind  = 8,   //place the segment on NUMA node numaNode
+    MemNumaInterleave = 16, //spread the segment pages over the NUMA nodes the creator may use
+} MemoryFlags;
+
+typedef enum StatsFlags {
+    StatsLockTimes = 1, //also time the rwlock waits and holds (lockWaitNs/lockHoldNs and their histograms).
+                        //Three clock reads and four shared atomic adds per locked call, so off by default
+} StatsFlags;
+
 typedef struct CHANNAL_INFO {
     char *channelName;
-    int  channelSize;
+    int  channelSize;        //bytes of the object buffers: objectSize each, Latest objects objectSize * slotCount
+    int  memoryFlags;        //MemoryFlags, also applied by the processes that join
+    int  numaNode;           //MemNumaBind only
+    int  objectCount;        //objects the channel will hold. Their locks, counters and names (about 1.7 KB each)
+                             //are added to channelSize. 0: channelSize has to cover them as well
 } st_CHANNAL_INFO;
 
+typedef enum ObjectMode {
+    RwLock  = 0,    //readers and the publisher share a reader/writer lock
+    SeqLock = 1,    //the publisher never waits for readers, readers copy optimistically and retry
+    Latest  = 2,    //slotCount buffers: the publisher fills a free one and flips "latest" to it,
+                    //readers pin the latest one while copying. Use slotCount >= concurrent readers + 2
+                    //so that the publisher never waits
+} ObjectMode;
+
 typedef struct OBJECT_INFO {
     char *objectName;
     int  objectSize;
+    ObjectMode objectMode;   //0:rwlock  1:seqlock  2:latest
+    int  slotCount;          //latest only: number of buffers, 2..16 (0 means 3)
+    int  statsFlags;         //StatsFlags
 } st_OBJECT_INFO;
 
 typedef enum QueueMode {
     Polling = 0,
-    Notify  = 1,
+    Notify  = 1,    //like polling, but retrieving blocks until a message newer than the last one read is published
+    Spsc    = 2,    //lock-free ring for exactly one publisher and one consumer process, never blocks
+    Mpmc    = 3,    //lock-free ring for many publishers and consumers, each message goes to one consumer
 } QueueMode;
 
 typedef struct QUEUE_INFO {
     char *queueName;
     int  maxElementSize;
     int  maxQueueSize;
-    QueueMode queueMode;     //0:polling  1:notify
+    QueueMode queueMode;     //0:polling  1:notify  2:spsc  3:mpmc
+    unsigned int queueBytes; //polling/notify only, 0: one maxElementSize slot per message
+                             //otherwise messages are packed in a ring of queueBytes bytes and the oldest
+                             //are dropped once it (or maxQueueSize) is full
+    int  memoryFlags;        //MemoryFlags, also applied by the processes that join
+    int  numaNode;           //MemNumaBind only
+    int  statsFlags;         //StatsFlags
 } st_QUEUE_INFO;
 
 typedef enum ErrorCode {
@@ -45,13 +83,55 @@ typedef enum ErrorCode {
     Invalid     = -2,
     MemLack     = -3,
     NoData      = -4,
-    DataLost    = -5
+    DataLost    = -5,
+    Busy        = -6,   //flags 0: the call would have to wait for another process, try again later
+    Timeout     = -7    //timed calls: nothing arrived (or the lock stayed taken) until the deadline
 } ErrorCode;
 
+#define BOCOM_STATS_BUCKETS 20
+
+/* Counters of a queue or an object, kept in shared memory and summed over every process using it.
+ * Histogram bucket 0 counts the times below 64ns, bucket i those from 32ns << i to 64ns << i,
+ * the last bucket everything longer
+ */
+typedef struct STATS_INFO {
+    unsigned long long publishes;   //messages published (objects: publishes and released write acquires)
+    unsigned long long retrieves;   //messages retrieved or peeked (objects: retrieves and released read acquires)
+    unsigned long long dataLost;    //retrieves and releases that returned DataLost
+    unsigned long long noData;      //retrieves that found nothing: NoData or Timeout
+    unsigned long long busy;        //calls that returned Busy
+    unsigned long long depth;       //queues: messages queued now, 0 for objects
+    unsigned long long lockWaitNs;  //total time spent waiting for the rwlock (Polling/Notify queues, RwLock objects),
+                                    //only with StatsLockTimes, 0 like the histograms otherwise
+    unsigned long long lockHoldNs;  //total time the rwlock was held
+    unsigned long long lockWait[BOCOM_STATS_BUCKETS];
+    unsigned long long lockHold[BOCOM_STATS_BUCKETS];
+} st_STATS_INFO;
+
+typedef struct SEGMENT_INFO {
+    unsigned long long size;        //bytes of the shared memory segment
+    unsigned long long freeMemory;  //bytes its allocator can still hand out
+    int  isQueue;                   //1: queue  0: channel
+    int  entries;                   //queue: 1  channel: objects in it
+} st_SEGMENT_INFO;
+
+typedef struct ENTRY_INFO {
+    char name[128];
+    int  elementSize;               //objectSize or maxElementSize
+    int  mode;                      //ObjectMode or QueueMode
+    int  capacity;                  //object: buffers (Latest: slotCount, 1 otherwise)  queue: maxQueueSize
+    st_STATS_INFO stats;
+} st_ENTRY_INFO;
+
+typedef struct CONSUMER_INFO {
+    int  pid;                       //process that joined the queue
+    unsigned long long lag;         //queued messages it has not retrieved yet
+} st_CONSUMER_INFO;
+
 typedef void* Context;
 
 /* brief:  Create a channel before use. Then you can join it by channel-name in other processes
- *          Since some shared memory is occupied internally, you must apply for a larger memory
+ *          Since some shared memory is occupied internally, set objectCount or apply for a larger memory
  *           (It depends on the number of objects you will use),
  *          otherwise "boost::interprocess::bad_alloc" will appear
  * param:  channel info
@@ -78,7 +158,7 @@ ErrorCode BOCOM_CheckObjectExist(Context chnCtx, char *objectName);
 ErrorCode BOCOM_DestroyObject(Context chnCtx,st_OBJECT_INFO *info);
 
 /* brief:  Publish the value(data) to object
- * param:  1.object context   2.value  3.valueLength  4.flags(for blocking: 0 non-blocking  1 blocking mode  2 condition(send first))
+ * param:  1.object context   2.value  3.valueLength  4.flags(for blocking: 0 non-blocking, Busy when it would wait  1 blocking mode  2 condition(send first))
  * return: ErrorCode
  */
 ErrorCode BOCOM_Publish(Context chnCtx,char* objectName,void* value,int valueLength,int flags);
@@ -91,13 +171,111 @@ ErrorCode BOCOM_Publish(Context chnCtx,char* objectName,void* value,int valueLen
 Context BOCOM_JoinChannel(char *channelName);
 
 /* brief:  Get data from the previously constructed object
- * param:  1.channel context   2.object name  3.output value  4.flags(for blocking: 0 non-blocking  1 blocking mode  2 condition(Receive after sending))
+ * param:  1.channel context   2.object name  3.output value  4.flags(for blocking: 0 non-blocking, Busy when it would wait  1 blocking mode  2 condition(Receive after sending))
  * return: ErrorCode
  */
 ErrorCode BOCOM_Retrieve(Context chnCtx, char* objectName, void* outPutValue, int valueLength, int flags);
 
+/* brief:  Same as BOCOM_Retrieve, but waiting for the lock (and with flags 2 for the next publish) at most timeoutMs
+ * param:  1.channel context   2.object name  3.output value  4.valueLength  5.flags(same as BOCOM_Retrieve)  6.timeout in ms
+ * return: ErrorCode (Timeout when the deadline passed)
+ */
+ErrorCode BOCOM_RetrieveTimed(Context chnCtx, char *objectName, void *outPutValue, int valueLength, int flags, int timeoutMs);
+
+
+/* brief:  Resolve an object once, so that BOCOM_PublishObject/BOCOM_RetrieveObject need no name lookups.
+ *          The returned context becomes invalid when the object is destroyed
+ * param:  1.channel context   2.object name
+ * return: object context (NULL if the object cannot be found)
+ */
+Context BOCOM_OpenObject(Context chnCtx, char *objectName);
+
+/* brief:  Release the object context returned by BOCOM_OpenObject (the object itself is kept)
+ * param:  object context
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_CloseObject(Context objCtx);
+
+/* brief:  Same as BOCOM_Publish, but on an object opened by BOCOM_OpenObject
+ * param:  1.object context   2.value  3.valueLength  4.flags(same as BOCOM_Publish)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_PublishObject(Context objCtx, void *value, int valueLength, int flags);
+
+/* brief:  Same as BOCOM_PublishObject, but the value is gathered from several fragments straight into shared memory
+ * param:  1.object context   2.fragments  3.number of fragments  4.flags(same as BOCOM_Publish)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_PublishObjectV(Context objCtx, const struct iovec *iov, int iovcnt, int flags);
+
+/* brief:  Same as BOCOM_Retrieve, but on an object opened by BOCOM_OpenObject
+ * param:  1.object context   2.output value  3.valueLength  4.flags(same as BOCOM_Retrieve)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_RetrieveObject(Context objCtx, void *outPutValue, int valueLength, int flags);
+
+/* brief:  Same as BOCOM_RetrieveObject, but the value is scattered over several fragments, filled in order
+ * param:  1.object context   2.fragments  3.number of fragments  4.flags(same as BOCOM_Retrieve)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_RetrieveObjectV(Context objCtx, const struct iovec *iov, int iovcnt, int flags);
+
+/* brief:  Same as BOCOM_RetrieveTimed, but on an object opened by BOCOM_OpenObject
+ * param:  1.object context   2.output value  3.valueLength  4.flags(same as BOCOM_Retrieve)  5.timeout in ms
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_RetrieveObjectTimed(Context objCtx, void *outPutValue, int valueLength, int flags, int timeoutMs);
+
+
+/* brief:  Get the address of an opened object in shared memory to update it in place, no copy is made.
+ *          Finish with BOCOM_ReleaseObject. An object context holds at most one acquire
+ *          RwLock: the write lock is held until the release
+ *          SeqLock: readers retry (or get DataLost from their release) until the release
+ *          Latest: a free buffer is handed out, pre-filled with the latest value, and becomes the latest at release
+ * param:  1.object context   2.output: address of the object  3.flags(same as BOCOM_Publish, 2 notifies at release)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_AcquireObjectWrite(Context objCtx, void **ptr, int flags);
+
+/* brief:  Get the read-only address of an opened object in shared memory to read it in place, no copy is made.
+ *          Finish with BOCOM_ReleaseObject. An object context holds at most one acquire
+ *          RwLock: the read lock is held until the release
+ *          SeqLock: no lock is held, the release returns DataLost if a publisher ran meanwhile (read again)
+ *          Latest: the latest buffer is pinned until the release
+ * param:  1.object context   2.output: address of the object  3.flags(same as BOCOM_Retrieve)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_AcquireObjectRead(Context objCtx, const void **ptr, int flags);
+
+/* brief:  Release the object acquired by BOCOM_AcquireObjectWrite/BOCOM_AcquireObjectRead
+ * param:  object context
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_ReleaseObject(Context objCtx);
+
+/* brief:  Get a descriptor for epoll/poll that becomes readable when the object is published with flags 2.
+ *          It is owned by the object context and closed by BOCOM_CloseObject (close it before destroying
+ *          the object). Every retrieve/read acquire on the context clears it again
+ * param:  object context
+ * return: file descriptor (-1 on failure, at most 16 descriptors per object)
+ */
+int BOCOM_GetObjectFd(Context objCtx);
+
+/* brief:  Get the NUMA node the object data lives on, to run the threads that use it on the same node
+ * param:  object context
+ * return: node number (-1 on failure)
+ */
+int BOCOM_GetObjectNode(Context objCtx);
+
+/* brief:  Read the counters of an opened object, they are updated by every process using it
+ * param:  1.object context   2.output: counters
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_GetObjectStats(Context objCtx, st_STATS_INFO *stats);
+
 
 /* brief:  Create a data queue. Then you can join it by queue-name in other processes
+ *          All maxQueueSize slots are reserved here, publishing never allocates
  * param:  queue info: Include queueName maxElementSize maxQueueSize queueMode
  * return: queue context
  */
@@ -115,6 +293,19 @@ ErrorCode BOCOM_DestroyQueue(Context context);
  */
 ErrorCode BOCOM_PublishQueue(Context context, const void *value, unsigned int valueLength);
 
+/* brief:  Publish one message gathered from several fragments, e.g. a header and a payload kept apart
+ * param:  1.queue context   2.fragments  3.number of fragments
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_PublishQueueV(Context context, const struct iovec *iov, int iovcnt);
+
+/* brief:  Publish several messages under one lock hold, consumers are woken once for the whole batch.
+ *          Nothing is published if one of the messages is empty or larger than maxElementSize
+ * param:  1.queue context   2.messages  3.number of messages
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_PublishQueueBatch(Context context, const struct iovec *msgs, int count);
+
 /* brief:  Other processes can join the queue in order to obtain objects
  * param:  queue name
  * return: queue context
@@ -133,6 +324,111 @@ ErrorCode BOCOM_QuitQueue(Context context);
  */
 ErrorCode BOCOM_RetrieveQueue(Context context, void *value, unsigned int *valueLength);
 
+/* brief:  Get one message scattered over several fragments, filled in order. What does not fit is dropped,
+ *          valueLength still reports the full message length
+ * param:  1.queue context  2.fragments  3.number of fragments  4.output: length of the message
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_RetrieveQueueV(Context context, const struct iovec *iov, int iovcnt, unsigned int *valueLength);
+
+/* brief:  Get data from the previously joined queue, waiting at most timeoutMs for a message in every mode.
+ *          Every mode sleeps until a publish. Once a context used it, the publishers of Polling/Spsc/Mpmc queues
+ *          also wake the futex, like Notify ones do. 0 only checks once
+ * param:  1.queue context  2.output value  3.length of the output value  4.timeout in ms
+ * return: ErrorCode (Timeout when no message arrived before the deadline)
+ */
+ErrorCode BOCOM_RetrieveQueueTimed(Context context, void *value, unsigned int *valueLength, int timeoutMs);
+
+/* brief:  Get every available message, up to maxCount, in one call. Each buffer must hold maxElementSize bytes.
+ *          Notify queues wait for the first message like BOCOM_RetrieveQueue, the rest never wait
+ * param:  1.queue context  2.output buffers  3.output lengths  4.number of buffers  5.output: messages copied
+ *          6.output: messages lost to overwrite before them (can be NULL)
+ * return: ErrorCode (DataLost when messages were lost, NoData when nothing was copied)
+ */
+ErrorCode BOCOM_RetrieveQueueBatch(Context context, void **bufs, unsigned int *lens, int maxCount, int *got, unsigned int *lost);
+
+/* brief:  Get the next message in place instead of copying it, like BOCOM_RetrieveQueue.
+ *          The message is pinned, publishers cannot overwrite it until BOCOM_ReleaseQueue.
+ *          A context holds at most one peeked message, keep it short:
+ *          Polling/Notify: publishers of the queue wait until the release
+ *          Spsc/Mpmc: publishers only wait once they wrap around to the pinned slot
+ * param:  1.queue context  2.output: read-only address of the message  3.output: length  4.output: token for the release
+ * return: ErrorCode (Success and DataLost hand out a message that must be released)
+ */
+ErrorCode BOCOM_PeekQueue(Context context, const void **ptr, unsigned int *valueLength, unsigned long long *token);
+
+/* brief:  Release the message pinned by BOCOM_PeekQueue, its address must not be used afterwards
+ * param:  1.queue context  2.token returned by BOCOM_PeekQueue
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_ReleaseQueue(Context context, unsigned long long token);
+
+/* brief:  Get a descriptor for epoll/poll that becomes readable when new messages are published, in every queue mode.
+ *          When it is readable, retrieve (or peek) until NoData: the descriptor is cleared and armed again
+ *          only by the call that finds nothing (Notify: BOCOM_RetrieveQueueTimed with timeout 0 until Timeout).
+ *          It is owned by the queue context and closed by BOCOM_QuitQueue
+ * param:  queue context
+ * return: file descriptor (-1 on failure, at most 16 descriptors per queue)
+ */
+int BOCOM_GetQueueFd(Context context);
+
+/* brief:  Get the NUMA node the queue slots live on, to run the threads that use it on the same node
+ * param:  queue context
+ * return: node number (-1 on failure)
+ */
+int BOCOM_GetQueueNode(Context context);
+
+/* brief:  Read the counters of the queue, they are updated by every process that created or joined it
+ * param:  1.queue context   2.output: counters
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_GetQueueStats(Context context, st_STATS_INFO *stats);
+
+/* brief:  Loan a slot of the queue, so the message is written into shared memory directly, without any copy.
+ *          A context holds at most one loan, finish it with BOCOM_CommitQueueSlot
+ *          (Spsc/Mpmc: consumers cannot get past the loaned slot until it is committed, keep the loan short)
+ *          Not available for queues created with queueBytes (Invalid)
+ *          On a full queue the loan takes the room of the oldest message, which is dropped at once
+ *          and stays dropped when the loan is given back
+ * param:  1.queue context  2.size needed (at most maxElementSize)  3.output: address of the slot
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_LoanQueueSlot(Context context, unsigned int size, void **ptr);
+
+/* brief:  Publish the slot loaned by BOCOM_LoanQueueSlot
+ * param:  1.queue context  2.address of the slot  3.length written (0 gives the slot back unpublished)
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_CommitQueueSlot(Context context, void *ptr, unsigned int actualLen);
+
+
+/* brief:  Attach to a channel or a queue read-only, for monitoring. Nothing in it is written and no lock is taken,
+ *          the processes using it are not disturbed
+ * param:  channel or queue name
+ * return: inspect context (NULL if there is no such channel or queue)
+ */
+Context BOCOM_AttachInspect(const char *name);
+
+/* brief:  Detach what BOCOM_AttachInspect attached
+ * param:  inspect context
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_DetachInspect(Context inspCtx);
+
+/* brief:  Read the segment memory and the counters of its objects (channel) or of the queue.
+ *          Objects constructed or destroyed meanwhile may be missed
+ * param:  1.inspect context  2.output: segment  3.output: entries  4.number of entries  5.output: entries filled
+ * return: ErrorCode
+ */
+ErrorCode BOCOM_InspectSegment(Context inspCtx, st_SEGMENT_INFO *info, st_ENTRY_INFO *entries, int maxCount, int *count);
+
+/* brief:  List the processes that retrieve from the queue and how far each one is behind (at most 64 are listed).
+ *          A context is listed from its first retrieve or peek on, publishers are not
+ * param:  1.inspect context  2.output: consumers  3.number of consumers  4.output: consumers filled
+ * return: ErrorCode (Invalid for a channel)
+ */
+ErrorCode BOCOM_InspectConsumers(Context inspCtx, st_CONSUMER_INFO *consumers, int maxCount, int *count);
+
 #ifdef __cplusplus
 };
 #endif
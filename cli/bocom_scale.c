@@ -0,0 +1,534 @@
+#define _GNU_SOURCE
+#include "bocom_ipc.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+/* Multi-process latency and fan-out scaling: for 1, 2, 4 .. N subscribers one publisher process forks
+ * the subscriber processes, every process pinned to its own CPU (shared round-robin when there are fewer).
+ *
+ *  rtt         the publisher sends a ping and waits until every subscriber answered it (fan-out round trip)
+ *  oneway      publish to the subscriber reading it, one sample per subscriber and ping
+ *  throughput  queue only: messages go out in windows of WINDOW, every subscriber acknowledges the last
+ *              one of each window before the next window is sent, so no subscriber falls behind the queue
+ *
+ * Pings go over a Notify queue or an RwLock object published with flags 2, whose subscribers poll
+ * BOCOM_GetObjectFd and read with BOCOM_RetrieveObject,
+ * the answers always over one Notify queue all subscribers publish into. Times are CLOCK_MONOTONIC,
+ * system-wide so that the one-way times compare the clocks of two processes.
+ *
+ * usage: bocom_scale [-n max subscribers, default 32] [-r round trips, default 10000]
+ *                    [-m throughput messages, default 100000] [-s payload bytes, default 64]
+ *                    [-t queue|channel|both, default both] [-o csv file, default bocom_scale.csv, - for stdout]
+ */
+
+#define MAX_SUBSCRIBERS 32
+#define WINDOW 64
+#define WARMUP 100
+//A reply that takes longer than this means a subscriber is gone
+#define REPLY_TIMEOUT_MS 5000
+
+#define PING_QUEUE "bocom_scale_ping"
+#define PONG_QUEUE "bocom_scale_pong"
+#define PING_CHANNEL "bocom_scale_chn"
+#define PING_OBJECT "bocom_scale_ping"
+
+typedef enum
+{
+    TransportQueue = 0,
+    TransportChannel = 1,
+} Transport;
+
+typedef enum
+{
+    MsgReady = 0,   //subscriber -> publisher: joined, waiting for pings
+    MsgPing,        //answered by every subscriber
+    MsgData,        //throughput message, not answered
+    MsgDataAck,     //last message of a window, answered
+    MsgQuit,
+} MsgKind;
+
+typedef struct
+{
+    unsigned long long seq;
+    long long timeNs;   //publisher: CLOCK_MONOTONIC of the publish  subscriber: of the receipt
+    int kind;
+    int subscriber;
+} st_SCALE_MSG;
+
+typedef struct
+{
+    int maxSubscribers;
+    int rounds;
+    int messages;
+    int payload;        //bytes per ping/message, at least sizeof(st_SCALE_MSG)
+} st_SCALE_ARGS;
+
+typedef struct
+{
+    Context chnCtx;
+    Context objCtx;
+    Context queCtx;
+    int objFd;          //subscribers of the channel: readable once the object is published
+} st_PING;
+
+static int g_cpus[CPU_SETSIZE];
+static int g_cpuCount = 0;
+
+static long long NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//The CPUs this process may run on, the publisher takes the first, subscriber i the (i + 1)th
+static void LoadCpus(void)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (0 != sched_getaffinity(0, sizeof(set), &set))
+    {
+        g_cpus[0] = 0;
+        g_cpuCount = 1;
+        return;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &set))
+        {
+            g_cpus[g_cpuCount++] = cpu;
+        }
+    }
+}
+
+static void PinToCpu(int slot)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(g_cpus[slot % g_cpuCount], &set);
+    if (0 != sched_setaffinity(0, sizeof(set), &set))
+    {
+        fprintf(stderr, "sched_setaffinity to cpu %d failed\n", g_cpus[slot % g_cpuCount]);
+    }
+}
+
+static int CompareNs(const void *a, const void *b)
+{
+    const long long x = *(const long long *)a;
+    const long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+//Nearest rank of a sorted array
+static long long Percentile(const long long *sorted, int count, double p)
+{
+    int rank = (int)(p * count + 0.999999);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+static const char *TransportName(Transport transport)
+{
+    return (transport == TransportQueue) ? "queue" : "channel";
+}
+
+static ErrorCode SendPing(Transport transport, st_PING *ping, void *msg, int length)
+{
+    if (transport == TransportQueue)
+    {
+        return BOCOM_PublishQueue(ping->queCtx, msg, length);
+    }
+    return BOCOM_PublishObject(ping->objCtx, msg, length, 2);
+}
+
+/* Next message after lastSeq. Returns Timeout when nothing came within about a second,
+ * so that the caller can check whether the publisher is still there
+ */
+static ErrorCode ReceivePing(Transport transport, st_PING *ping, void *msg, int length, unsigned long long lastSeq)
+{
+    unsigned int recLen = 0;
+    if (transport == TransportQueue)
+    {
+        const ErrorCode ret = BOCOM_RetrieveQueueTimed(ping->queCtx, msg, &recLen, 1000);
+        //DataLost still delivers the oldest message, it shows up in the lost column
+        return (ret == DataLost) ? Success : ret;
+    }
+
+    //The retrieve clears the descriptor before it reads, so a publish after the read still wakes the poll
+    for (;;)
+    {
+        const ErrorCode ret = BOCOM_RetrieveObject(ping->objCtx, msg, length, 1);
+        if (ret != Success)
+        {
+            return ret;
+        }
+        if (((st_SCALE_MSG *)msg)->seq != lastSeq)
+        {
+            return Success;
+        }
+        struct pollfd pfd = {ping->objFd, POLLIN, 0};
+        if (0 == poll(&pfd, 1, 1000))
+        {
+            return Timeout;
+        }
+    }
+}
+
+static int RunSubscriber(Transport transport, int index, const st_SCALE_ARGS *args)
+{
+    const pid_t publisher = getppid();
+    st_PING ping = {NULL, NULL, NULL, -1};
+    if (transport == TransportQueue)
+    {
+        ping.queCtx = BOCOM_JoinQueue(PING_QUEUE);
+    }
+    else
+    {
+        ping.chnCtx = BOCOM_JoinChannel(PING_CHANNEL);
+        ping.objCtx = (NULL != ping.chnCtx) ? BOCOM_OpenObject(ping.chnCtx, PING_OBJECT) : NULL;
+        ping.objFd = (NULL != ping.objCtx) ? BOCOM_GetObjectFd(ping.objCtx) : -1;
+    }
+    Context pongCtx = BOCOM_JoinQueue(PONG_QUEUE);
+    if ((NULL == ping.queCtx && ping.objFd < 0) || NULL == pongCtx)
+    {
+        fprintf(stderr, "subscriber %d: joining failed\n", index);
+        return -1;
+    }
+
+    void *msg = calloc(1, args->payload);
+    st_SCALE_MSG reply = {0, NowNs(), MsgReady, index};
+    BOCOM_PublishQueue(pongCtx, &reply, sizeof(reply));
+
+    unsigned long long lastSeq = 0;
+    for (;;)
+    {
+        const ErrorCode ret = ReceivePing(transport, &ping, msg, args->payload, lastSeq);
+        const long long now = NowNs();
+        if (ret == Timeout && getppid() == publisher)
+        {
+            continue;
+        }
+        if (ret != Success)
+        {
+            break;
+        }
+
+        const st_SCALE_MSG *in = (const st_SCALE_MSG *)msg;
+        lastSeq = in->seq;
+        if (in->kind == MsgQuit)
+        {
+            break;
+        }
+        if (in->kind == MsgPing || in->kind == MsgDataAck)
+        {
+            reply.seq = in->seq;
+            reply.timeNs = now;
+            reply.kind = in->kind;
+            BOCOM_PublishQueue(pongCtx, &reply, sizeof(reply));
+        }
+    }
+
+    free(msg);
+    BOCOM_QuitQueue(pongCtx);
+    if (transport == TransportQueue)
+    {
+        BOCOM_QuitQueue(ping.queCtx);
+    }
+    else
+    {
+        BOCOM_CloseObject(ping.objCtx);
+    }
+    return 0;
+}
+
+//Waits until all subscribers answered seq. oneway: one slot per subscriber, or NULL
+static int WaitReplies(Context pongCtx, int subscribers, unsigned long long seq, long long sentNs, long long *oneway)
+{
+    st_SCALE_MSG reply;
+    unsigned int recLen = 0;
+    int got = 0;
+    while (got < subscribers)
+    {
+        const ErrorCode ret = BOCOM_RetrieveQueueTimed(pongCtx, &reply, &recLen, REPLY_TIMEOUT_MS);
+        if (ret != Success && ret != DataLost)
+        {
+            fprintf(stderr, "waiting for the replies to %llu: %d of %d, ret %d\n", seq, got, subscribers, ret);
+            return -1;
+        }
+        if (reply.seq != seq)
+        {
+            continue;
+        }
+        if (NULL != oneway)
+        {
+            oneway[got] = reply.timeNs - sentNs;
+        }
+        got++;
+    }
+    return 0;
+}
+
+static void PrintLatency(FILE *out, Transport transport, int subscribers, const st_SCALE_ARGS *args, const char *test,
+                         long long *samples, int count, double perSecond)
+{
+    qsort(samples, count, sizeof(long long), CompareNs);
+    fprintf(out, "%s,%d,%d,%d,%s,%d,%lld,%lld,%lld,%lld,%.0f,%.2f,0\n", TransportName(transport), subscribers,
+            (subscribers + 1 < g_cpuCount) ? subscribers + 1 : g_cpuCount, args->payload, test, count,
+            Percentile(samples, count, 0.5), Percentile(samples, count, 0.99), Percentile(samples, count, 0.999),
+            samples[count - 1], perSecond, perSecond * args->payload / 1e6);
+}
+
+static int CreatePing(Transport transport, const st_SCALE_ARGS *args, st_PING *ping)
+{
+    if (transport == TransportQueue)
+    {
+        st_QUEUE_INFO info = {PING_QUEUE, args->payload, 2 * WINDOW, Notify, 0, 0, 0, 0};
+        ping->queCtx = BOCOM_CreateQueue(&info);
+        return (NULL != ping->queCtx) ? 0 : -1;
+    }
+
+    st_CHANNAL_INFO chnInfo = {PING_CHANNEL, args->payload, 0, 0, 1};
+    st_OBJECT_INFO objInfo = {PING_OBJECT, args->payload, RwLock, 0, 0};
+    ping->chnCtx = BOCOM_CreateChannel(&chnInfo);
+    if (NULL == ping->chnCtx || Success != BOCOM_ConstructObject(ping->chnCtx, &objInfo))
+    {
+        return -1;
+    }
+    ping->objCtx = BOCOM_OpenObject(ping->chnCtx, PING_OBJECT);
+    return (NULL != ping->objCtx) ? 0 : -1;
+}
+
+static void DestroyPing(Transport transport, const st_SCALE_ARGS *args, st_PING *ping)
+{
+    if (transport == TransportQueue)
+    {
+        BOCOM_DestroyQueue(ping->queCtx);
+        return;
+    }
+    st_OBJECT_INFO objInfo = {PING_OBJECT, args->payload, RwLock, 0, 0};
+    BOCOM_CloseObject(ping->objCtx);
+    BOCOM_DestroyObject(ping->chnCtx, &objInfo);
+}
+
+static int Measure(FILE *out, Transport transport, int subscribers, const st_SCALE_ARGS *args, st_PING *ping,
+                   Context pongCtx)
+{
+    st_SCALE_MSG *msg = calloc(1, args->payload);
+    long long *rtt = malloc(sizeof(long long) * args->rounds);
+    long long *oneway = malloc(sizeof(long long) * args->rounds * subscribers);
+    unsigned long long seq = 0;
+    int ret = -1;
+
+    //Everybody joined before the first ping
+    if (0 != WaitReplies(pongCtx, subscribers, 0, 0, NULL))
+    {
+        goto out;
+    }
+
+    const long long pingStart = NowNs();
+    for (int i = -WARMUP; i < args->rounds; i++)
+    {
+        msg->seq = ++seq;
+        msg->kind = MsgPing;
+        msg->timeNs = NowNs();
+        if (Success != SendPing(transport, ping, msg, args->payload) ||
+            0 != WaitReplies(pongCtx, subscribers, seq, msg->timeNs, (i < 0) ? NULL : oneway + (long)i * subscribers))
+        {
+            goto out;
+        }
+        if (i >= 0)
+        {
+            rtt[i] = NowNs() - msg->timeNs;
+        }
+    }
+    const double pingSeconds = (NowNs() - pingStart) / 1e9;
+    const double roundsPerSecond = (args->rounds + WARMUP) / pingSeconds;
+    PrintLatency(out, transport, subscribers, args, "rtt", rtt, args->rounds, roundsPerSecond);
+    PrintLatency(out, transport, subscribers, args, "oneway", oneway, args->rounds * subscribers,
+                 roundsPerSecond * subscribers);
+
+    //An object only keeps the latest value, there is no throughput to speak of
+    if (transport == TransportQueue && args->messages > 0)
+    {
+        st_STATS_INFO before, after;
+        BOCOM_GetQueueStats(ping->queCtx, &before);
+        const long long start = NowNs();
+        for (int i = 1; i <= args->messages; i++)
+        {
+            const int windowEnd = (0 == i % WINDOW || i == args->messages);
+            msg->seq = ++seq;
+            msg->kind = windowEnd ? MsgDataAck : MsgData;
+            msg->timeNs = NowNs();
+            if (Success != SendPing(transport, ping, msg, args->payload))
+            {
+                goto out;
+            }
+            if (windowEnd && 0 != WaitReplies(pongCtx, subscribers, seq, msg->timeNs, NULL))
+            {
+                goto out;
+            }
+        }
+        const double perSecond = args->messages / ((NowNs() - start) / 1e9);
+        BOCOM_GetQueueStats(ping->queCtx, &after);
+        fprintf(out, "%s,%d,%d,%d,throughput,%d,,,,,%.0f,%.2f,%llu\n", TransportName(transport), subscribers,
+                (subscribers + 1 < g_cpuCount) ? subscribers + 1 : g_cpuCount, args->payload, args->messages,
+                perSecond, perSecond * args->payload / 1e6, after.dataLost - before.dataLost);
+    }
+    ret = 0;
+
+out:
+    msg->seq = ++seq;
+    msg->kind = MsgQuit;
+    SendPing(transport, ping, msg, args->payload);
+    free(oneway);
+    free(rtt);
+    free(msg);
+    return ret;
+}
+
+//The publisher process of one data point: creates the queues, forks the subscribers and measures
+static int RunPublisher(FILE *out, Transport transport, int subscribers, const st_SCALE_ARGS *args)
+{
+    PinToCpu(0);
+
+    st_PING ping = {NULL, NULL, NULL, -1};
+    st_QUEUE_INFO pongInfo = {PONG_QUEUE, sizeof(st_SCALE_MSG), 2 * MAX_SUBSCRIBERS, Notify, 0, 0, 0, 0};
+    Context pongOwner = BOCOM_CreateQueue(&pongInfo);
+    Context pongCtx = (NULL != pongOwner) ? BOCOM_JoinQueue(PONG_QUEUE) : NULL;
+    if (NULL == pongCtx || 0 != CreatePing(transport, args, &ping))
+    {
+        fprintf(stderr, "creating the %s failed\n", TransportName(transport));
+        return -1;
+    }
+
+    pid_t pids[MAX_SUBSCRIBERS];
+    int forked = 0;
+    for (; forked < subscribers; forked++)
+    {
+        fflush(out);
+        pids[forked] = fork();
+        if (pids[forked] < 0)
+        {
+            break;
+        }
+        if (0 == pids[forked])
+        {
+            PinToCpu(forked + 1);
+            _exit(RunSubscriber(transport, forked, args) == 0 ? 0 : 1);
+        }
+    }
+
+    int ret = (forked == subscribers) ? Measure(out, transport, subscribers, args, &ping, pongCtx) : -1;
+    for (int i = 0; i < forked; i++)
+    {
+        //The quit message is lost when a subscriber is gone or far behind
+        if (0 != ret)
+        {
+            kill(pids[i], SIGTERM);
+        }
+        waitpid(pids[i], NULL, 0);
+    }
+
+    BOCOM_QuitQueue(pongCtx);
+    BOCOM_DestroyQueue(pongOwner);
+    DestroyPing(transport, args, &ping);
+    fflush(out);
+    return ret;
+}
+
+static void Usage(const char *name)
+{
+    printf("usage: %s [-n max subscribers] [-r round trips] [-m throughput messages] [-s payload bytes]\n"
+           "          [-t queue|channel|both] [-o csv file]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    st_SCALE_ARGS args = {MAX_SUBSCRIBERS, 10000, 100000, 64};
+    const char *transports = "both";
+    const char *outName = "bocom_scale.csv";
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:m:s:t:o:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': args.maxSubscribers = atoi(optarg); break;
+        case 'r': args.rounds = atoi(optarg); break;
+        case 'm': args.messages = atoi(optarg); break;
+        case 's': args.payload = atoi(optarg); break;
+        case 't': transports = optarg; break;
+        case 'o': outName = optarg; break;
+        default: Usage(argv[0]); return -1;
+        }
+    }
+    if (args.maxSubscribers < 1 || args.maxSubscribers > MAX_SUBSCRIBERS || args.rounds < 1 || args.messages < 0)
+    {
+        printf("1..%d subscribers and at least one round trip\n", MAX_SUBSCRIBERS);
+        return -1;
+    }
+    if (args.payload < (int)sizeof(st_SCALE_MSG))
+    {
+        args.payload = sizeof(st_SCALE_MSG);
+    }
+
+    //The library logs to stdout, a file keeps the CSV clean
+    FILE *out = (0 != strcmp(outName, "-")) ? fopen(outName, "w") : stdout;
+    if (NULL == out)
+    {
+        printf("fopen %s failed\n", outName);
+        return -1;
+    }
+
+    LoadCpus();
+    if (g_cpuCount < args.maxSubscribers + 1)
+    {
+        fprintf(stderr, "only %d cpus for up to %d processes, some share a cpu (see the cpus column)\n",
+                g_cpuCount, args.maxSubscribers + 1);
+    }
+
+    fprintf(out, "transport,subscribers,cpus,payload,test,count,p50_ns,p99_ns,p999_ns,max_ns,per_second,mb_per_second,lost\n");
+    int failed = 0;
+    for (int t = TransportQueue; t <= TransportChannel; t++)
+    {
+        if (0 != strcmp(transports, "both") && 0 != strcmp(transports, TransportName(t)))
+        {
+            continue;
+        }
+        //1, 2, 4 .. and the maximum itself
+        for (int subscribers = 1;; subscribers = (subscribers * 2 > args.maxSubscribers) ? args.maxSubscribers : subscribers * 2)
+        {
+            fflush(out);
+            const pid_t pid = fork();
+            if (0 == pid)
+            {
+                _exit(RunPublisher(out, t, subscribers, &args) == 0 ? 0 : 1);
+            }
+            int status = 0;
+            if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || 0 != WEXITSTATUS(status))
+            {
+                fprintf(stderr, "%s with %d subscribers failed\n", TransportName(t), subscribers);
+                failed = 1;
+            }
+            if (subscribers == args.maxSubscribers)
+            {
+                break;
+            }
+        }
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,148 @@
+#include "bocom_ipc.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+/* Live view of a channel or a queue, like vmstat: every interval one line per object (or for the queue)
+ * and, for a queue, one line per consumer. Attaches read-only, the processes using it are not disturbed
+ *
+ * usage: bocom_stat <channel or queue name> [interval in seconds, default 1] [count, default forever]
+ */
+
+#define MAX_ENTRIES 256
+#define MAX_CONSUMERS 64
+
+static const char *ModeName(int isQueue, int mode)
+{
+    static const char *objectModes[] = {"rwlock", "seqlock", "latest"};
+    static const char *queueModes[] = {"polling", "notify", "spsc", "mpmc"};
+    if (isQueue)
+    {
+        return (mode >= 0 && mode < 4) ? queueModes[mode] : "?";
+    }
+    return (mode >= 0 && mode < 3) ? objectModes[mode] : "?";
+}
+
+static unsigned long long LockCount(const unsigned long long *histogram)
+{
+    unsigned long long count = 0;
+    for (int i = 0; i < BOCOM_STATS_BUCKETS; i++)
+    {
+        count += histogram[i];
+    }
+    return count;
+}
+
+//Average time per lock hold (or wait) over the interval
+static unsigned long long LockAverage(unsigned long long ns, unsigned long long prevNs,
+                                      const unsigned long long *histogram, const unsigned long long *prevHistogram)
+{
+    const unsigned long long count = LockCount(histogram) - LockCount(prevHistogram);
+    return (count == 0) ? 0 : (ns - prevNs) / count;
+}
+
+static const st_ENTRY_INFO *FindEntry(const st_ENTRY_INFO *entries, int count, const char *name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (0 == strcmp(entries[i].name, name))
+        {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void PrintHeader(void)
+{
+    printf("%-24s %-8s %9s %6s %7s %10s %10s %8s %8s %8s %8s %8s\n", "name", "mode", "size", "cap", "depth",
+           "pub/s", "ret/s", "lost", "nodata", "busy", "wait_ns", "hold_ns");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <channel or queue name> [interval in seconds] [count]\n", argv[0]);
+        return -1;
+    }
+    const char *name = argv[1];
+    const int interval = (argc > 2) ? atoi(argv[2]) : 1;
+    const int rounds = (argc > 3) ? atoi(argv[3]) : 0;
+    if (interval <= 0)
+    {
+        printf("interval must be at least 1 second\n");
+        return -1;
+    }
+
+    Context inspCtx = BOCOM_AttachInspect(name);
+    if (NULL == inspCtx)
+    {
+        printf("BOCOM_AttachInspect %s failed !\n", name);
+        return -1;
+    }
+
+    static st_ENTRY_INFO entries[MAX_ENTRIES];
+    static st_ENTRY_INFO prevEntries[MAX_ENTRIES];
+    st_CONSUMER_INFO consumers[MAX_CONSUMERS];
+    int prevCount = 0;
+
+    for (int round = 0; rounds == 0 || round <= rounds; round++)
+    {
+        st_SEGMENT_INFO info;
+        int count = 0;
+        if (Success != BOCOM_InspectSegment(inspCtx, &info, entries, MAX_ENTRIES, &count))
+        {
+            printf("BOCOM_InspectSegment failed !\n");
+            break;
+        }
+
+        //The first round only takes the counters the rates start from
+        if (round > 0)
+        {
+            printf("%s %s: %llu bytes, %llu free, %d %s\n", info.isQueue ? "queue" : "channel", name, info.size,
+                   info.freeMemory, info.entries, info.isQueue ? "queue" : "objects");
+            PrintHeader();
+            for (int i = 0; i < count; i++)
+            {
+                const st_STATS_INFO *cur = &entries[i].stats;
+                const st_ENTRY_INFO *prevEntry = FindEntry(prevEntries, prevCount, entries[i].name);
+                static const st_STATS_INFO zero;
+                const st_STATS_INFO *prev = (NULL != prevEntry) ? &prevEntry->stats : &zero;
+                printf("%-24s %-8s %9d %6d %7llu %10llu %10llu %8llu %8llu %8llu %8llu %8llu\n", entries[i].name,
+                       ModeName(info.isQueue, entries[i].mode), entries[i].elementSize, entries[i].capacity, cur->depth,
+                       (cur->publishes - prev->publishes) / interval, (cur->retrieves - prev->retrieves) / interval,
+                       cur->dataLost - prev->dataLost, cur->noData - prev->noData, cur->busy - prev->busy,
+                       LockAverage(cur->lockWaitNs, prev->lockWaitNs, cur->lockWait, prev->lockWait),
+                       LockAverage(cur->lockHoldNs, prev->lockHoldNs, cur->lockHold, prev->lockHold));
+            }
+
+            int consumerCount = 0;
+            if (info.isQueue && Success == BOCOM_InspectConsumers(inspCtx, consumers, MAX_CONSUMERS, &consumerCount))
+            {
+                for (int i = 0; i < consumerCount; i++)
+                {
+                    //A consumer that exited without BOCOM_QuitQueue keeps its entry until another one takes it
+                    const int gone = (0 != kill(consumers[i].pid, 0) && errno == ESRCH);
+                    printf("  consumer pid %-8d lag %llu%s\n", consumers[i].pid, consumers[i].lag, gone ? " (exited)" : "");
+                }
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+
+        memcpy(prevEntries, entries, sizeof(st_ENTRY_INFO) * count);
+        prevCount = count;
+        if (rounds != 0 && round == rounds)
+        {
+            break;
+        }
+        sleep(interval);
+    }
+
+    BOCOM_DetachInspect(inspCtx);
+    return 0;
+}
@@ -4,8 +4,6 @@
 #include <string.h>
 #include <unistd.h>
 
-#if 1
-
 typedef struct
 {
     int a;
@@ -19,7 +17,8 @@ int main()
 
     st_CHANNAL_INFO chnInfo = {
         .channelName = "MyVideoChannel",
-        .channelSize = 2000};
+        .channelSize = 1200,
+        .objectCount = 3};
     Context chnCtx = BOCOM_CreateChannel(&chnInfo);
     if(NULL == chnCtx)
     {
@@ -73,107 +72,3 @@ int main()
 
     return 0;
 }
-
-//for test big-data
-#else
-
-#include <stdlib.h>
-#include <sys/time.h>
-
-static long long util_getCurrentTimeUs()
-{
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
-}
-
-int main()
-{
-    st_CHANNAL_INFO chnInfo = {
-        .channelName = "MyVideoChannel",
-        .channelSize = 6 * 1024 * 1024};
-    Context chnCtx = BOCOM_CreateChannel(&chnInfo);
-
-    printf("BOCOM_CreateChannel success\n");
-
-    st_OBJECT_INFO ObjInfoI = {
-        .objectName = "IFrameBuff",
-        .objectSize = 5 * 1024 * 1024};
-    BOCOM_ConstructObject(chnCtx, &ObjInfoI);
-
-    printf("BOCOM_ConstructObject I success\n");
-
-    int dataLen = 5 * 1024 * 1024;
-    void *tmpMsg = malloc(dataLen);
-    if (tmpMsg == NULL)
-    {
-        printf("malloc is NULL\n");
-        return -1;
-    }
-
-    FILE *fp = fopen("/mnt/4k-img.jpg", "r");
-    if (fp == NULL)
-    {
-        printf("fopen is NULL\n");
-        return -1;
-    }
-    fread(tmpMsg, 1, 5114738, fp);
-
-    int i = 0;
-
-    long long usedTime = 0;
-    long long waitTime = 0;
-    long long startTime = 0;
-    long long endTime = 0;
-    long long usedTimeMax = 0;
-    long long waitTimeMax = 0;
-
-    int nums = 2000;
-    while (i < nums)
-    {
-
-        startTime = util_getCurrentTimeUs();
-        if (0 != endTime)
-        {
-
-            long long tmp = (startTime - endTime);
-            if (waitTimeMax < tmp)
-            {
-                waitTimeMax = tmp;
-            }
-            waitTime = waitTime + tmp;
-        }
-
-        ErrorCode reti = BOCOM_Publish(chnCtx, ObjInfoI.objectName, tmpMsg, dataLen, 2);
-        if (reti != 0)
-        {
-            printf("BOCOM_Publish error %d\n", reti);
-        }
-
-        endTime = util_getCurrentTimeUs();
-        long long tmp = endTime - startTime;
-        if (usedTimeMax < tmp)
-        {
-            usedTimeMax = tmp;
-        }
-        usedTime = usedTime + tmp;
-
-        i++;
-        //usleep(10 * 1000);
-    }
-
-    printf("average waitTime : %lld\n", waitTime / (nums - 1));
-    printf("average usedTime : %lld\n", usedTime / (nums));
-    printf("usedTimeMax : %lld\n", usedTimeMax);
-    printf("waitTimeMax : %lld\n", waitTimeMax);
-
-    if (tmpMsg != NULL)
-    {
-        free(tmpMsg);
-    }
-    fclose(fp);
-
-    return 0;
-}
-
-#endif
@@ -37,10 +37,12 @@ int main()
     while (1)
     {
         memset(tmpMsg, 0, 100);
-        reti = BOCOM_RetrieveQueue(queCtx, tmpMsg, &recLen);
+        reti = BOCOM_RetrieveQueueTimed(queCtx, tmpMsg, &recLen, 1000);
+        if (reti == Timeout)
+        {
+            continue;
+        }
         printf("main rec IFrameBuff rec:%s len:%d ret:%d \n",tmpMsg,recLen,reti);
-
-        usleep(100*1000);
     }
 
 #else
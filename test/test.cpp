@@ -1,13 +1,22 @@
 #include "bocom_ipc.h"
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
 #include <vector>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 TEST(BCOMTest, QueueTest)
 {
     constexpr auto maxElementSize = 1024;
     constexpr auto queueSize = 3;
-    st_QUEUE_INFO queueInfo = {"test", maxElementSize, queueSize, Polling};
+    st_QUEUE_INFO queueInfo = {"test", maxElementSize, queueSize, Polling, 0, 0, 0, 0};
     auto pubContext = BOCOM_CreateQueue(&queueInfo);
     ASSERT_NE(pubContext, nullptr);
 
@@ -32,3 +41,1391 @@ TEST(BCOMTest, QueueTest)
     ASSERT_EQ(pubElement1, subElement1);
     ASSERT_EQ(pubElement2, subElement2);
 }
+
+TEST(BCOMTest, NotifyQueueTest)
+{
+    constexpr auto maxElementSize = 64;
+    st_QUEUE_INFO queueInfo = {(char *)"test_notify", maxElementSize, 4, Notify, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_notify");
+    ASSERT_NE(subContext, nullptr);
+
+    // Messages published before the retrieve are returned without waiting.
+    int value = 1;
+    ASSERT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+    value = 2;
+    ASSERT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+    int out = 0;
+    unsigned int outLength = sizeof(out);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &out, &outLength), Success);
+    ASSERT_EQ(out, 1);
+    outLength = sizeof(out);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &out, &outLength), Success);
+    ASSERT_EQ(out, 2);
+
+    // A caught-up consumer sleeps until the next publish wakes it.
+    std::atomic<bool> woken(false);
+    int received = 0;
+    std::thread consumer([&] {
+        unsigned int length = sizeof(received);
+        EXPECT_EQ(BOCOM_RetrieveQueue(subContext, &received, &length), Success);
+        woken = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(woken);
+    value = 3;
+    ASSERT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+    consumer.join();
+    ASSERT_EQ(received, 3);
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, ObjectHandleTest)
+{
+    constexpr auto objectSize = 256;
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"object", objectSize, RwLock, 0, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+
+    ASSERT_EQ(BOCOM_OpenObject(chnCtx, (char *)"missing"), nullptr);
+    auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(objCtx, nullptr);
+
+    // The handle and the name based calls see the same object.
+    auto pubValue = std::vector<char>(objectSize, 0x5a);
+    auto subValue = std::vector<char>(objectSize, 0);
+    ASSERT_EQ(BOCOM_PublishObject(objCtx, pubValue.data(), pubValue.size(), 1), Success);
+    ASSERT_EQ(BOCOM_Retrieve(chnCtx, objInfo.objectName, subValue.data(), subValue.size(), 1), Success);
+    ASSERT_EQ(pubValue, subValue);
+
+    pubValue.assign(objectSize, 0x33);
+    ASSERT_EQ(BOCOM_Publish(chnCtx, objInfo.objectName, pubValue.data(), pubValue.size(), 1), Success);
+    ASSERT_EQ(BOCOM_RetrieveObject(objCtx, subValue.data(), subValue.size(), 1), Success);
+    ASSERT_EQ(pubValue, subValue);
+
+    // Oversized values are rejected instead of overrunning the object.
+    auto bigValue = std::vector<char>(objectSize + 1, 0);
+    ASSERT_EQ(BOCOM_PublishObject(objCtx, bigValue.data(), bigValue.size(), 1), Invalid);
+
+    ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}
+
+TEST(BCOMTest, ChannelSizeTest)
+{
+    // With objectCount the channel only needs the buffers, whatever the mode and the name length.
+    const std::string longName(100, 'n');
+    std::vector<st_OBJECT_INFO> objects = {{(char *)"IFrameBuff", 1000, RwLock, 0, 0},
+                                           {(char *)"PFrameBuff", 100, RwLock, 0, 0},
+                                           {(char *)"seqlock", 37, SeqLock, 0, 0},
+                                           {(char *)"latest", 64, Latest, 4, 0},
+                                           {(char *)longName.c_str(), 1, RwLock, 0, 0}};
+    int buffers = 0;
+    for (const auto &object : objects)
+    {
+        buffers += object.objectSize * (object.objectMode == Latest ? object.slotCount : 1);
+    }
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", buffers, 0, 0, static_cast<int>(objects.size())};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    for (auto &object : objects)
+    {
+        ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &object), Success);
+    }
+    for (auto &object : objects)
+    {
+        ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &object), Success);
+    }
+}
+
+TEST(BCOMTest, SpscQueueTest)
+{
+    constexpr auto maxElementSize = 64;
+    constexpr auto queueSize = 3;
+    st_QUEUE_INFO queueInfo = {(char *)"test_spsc", maxElementSize, queueSize, Spsc, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_spsc");
+    ASSERT_NE(subContext, nullptr);
+
+    uint64_t value = 0;
+    unsigned int valueLength = 0;
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), NoData);
+
+    for (uint64_t i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+    }
+    for (uint64_t i = 0; i < 2; i++)
+    {
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+        ASSERT_EQ(value, i);
+        ASSERT_EQ(valueLength, sizeof(value));
+    }
+
+    // Overflow by two: the oldest messages are dropped and reported once.
+    for (uint64_t i = 2; i < 2 + queueSize + 2; i++)
+    {
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+    }
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), DataLost);
+    ASSERT_EQ(value, 4u);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+    ASSERT_EQ(value, 5u);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+    ASSERT_EQ(value, 6u);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), NoData);
+
+    auto bigValue = std::vector<char>(maxElementSize + 1, 0);
+    ASSERT_EQ(BOCOM_PublishQueue(pubContext, bigValue.data(), bigValue.size()), Invalid);
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, SpscQueueConcurrentTest)
+{
+    constexpr uint64_t messageCount = 200000;
+    st_QUEUE_INFO queueInfo = {(char *)"test_spsc", 256, 8, Spsc, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_spsc");
+    ASSERT_NE(subContext, nullptr);
+
+    std::thread producer([pubContext]() {
+        // Every byte of a message carries its sequence number, so torn copies are visible.
+        auto msg = std::vector<uint64_t>(32);
+        for (uint64_t i = 1; i <= messageCount; i++)
+        {
+            msg.assign(msg.size(), i);
+            BOCOM_PublishQueue(pubContext, msg.data(), msg.size() * sizeof(uint64_t));
+        }
+    });
+
+    auto msg = std::vector<uint64_t>(32);
+    unsigned int msgLength = 0;
+    uint64_t last = 0;
+    while (last < messageCount)
+    {
+        const auto ret = BOCOM_RetrieveQueue(subContext, msg.data(), &msgLength);
+        if (ret == NoData)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_TRUE(ret == Success || ret == DataLost);
+        ASSERT_EQ(msgLength, msg.size() * sizeof(uint64_t));
+        ASSERT_GT(msg[0], last);
+        if (ret == Success && last != 0)
+        {
+            ASSERT_EQ(msg[0], last + 1);
+        }
+        ASSERT_EQ(std::count(msg.begin(), msg.end(), msg[0]), static_cast<long>(msg.size()));
+        last = msg[0];
+    }
+    producer.join();
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, MpmcQueueTest)
+{
+    constexpr auto queueSize = 4;
+    st_QUEUE_INFO queueInfo = {(char *)"test_mpmc", 64, queueSize, Mpmc, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_mpmc");
+    ASSERT_NE(subContext, nullptr);
+
+    uint64_t value = 0;
+    unsigned int valueLength = 0;
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), NoData);
+
+    // Overflow by one: the oldest message is dropped and reported once.
+    for (uint64_t i = 0; i < queueSize + 1; i++)
+    {
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+    }
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), DataLost);
+    ASSERT_EQ(value, 1u);
+    ASSERT_EQ(valueLength, sizeof(value));
+    for (uint64_t i = 2; i < queueSize + 1; i++)
+    {
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), NoData);
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, MpmcQueueSlowConsumerTest)
+{
+    // As many messages as slots: a peek on the oldest one blocks the slot the next publish wraps to.
+    constexpr auto queueSize = 4;
+    st_QUEUE_INFO queueInfo = {(char *)"test_mpmc", 64, queueSize, Mpmc, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_mpmc");
+    ASSERT_NE(subContext, nullptr);
+
+    for (uint64_t i = 1; i <= queueSize; i++)
+    {
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+    }
+    const void *ptr = nullptr;
+    unsigned int valueLength = 0;
+    unsigned long long token = 0;
+    ASSERT_EQ(BOCOM_PeekQueue(subContext, &ptr, &valueLength, &token), Success);
+    ASSERT_EQ(*static_cast<const uint64_t *>(ptr), 1u);
+
+    // The queue is not full, so the publisher waits for the slot instead of dropping the queued messages.
+    std::atomic<bool> published(false);
+    std::thread publisher([&]() {
+        uint64_t next = queueSize + 1;
+        BOCOM_PublishQueue(pubContext, &next, sizeof(next));
+        published = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_FALSE(published.load());
+    ASSERT_EQ(BOCOM_ReleaseQueue(subContext, token), Success);
+    publisher.join();
+
+    uint64_t value = 0;
+    for (uint64_t i = 2; i <= queueSize + 1; i++)
+    {
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), NoData);
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, MpmcQueueConcurrentTest)
+{
+    constexpr auto producerCount = 3;
+    constexpr auto consumerCount = 2;
+    constexpr uint32_t messageCount = 50000;
+    // Deep enough that nothing is dropped, so every message must arrive exactly once.
+    st_QUEUE_INFO queueInfo = {(char *)"test_mpmc", 64, producerCount * messageCount, Mpmc, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < producerCount; p++)
+    {
+        producers.emplace_back([pubContext, p]() {
+            for (uint32_t i = 0; i < messageCount; i++)
+            {
+                const uint32_t msg[2] = {p, i};
+                BOCOM_PublishQueue(pubContext, msg, sizeof(msg));
+            }
+        });
+    }
+
+    std::atomic<uint32_t> received(0);
+    std::vector<std::vector<uint32_t>> seen(consumerCount * producerCount);
+    std::vector<std::thread> consumers;
+    for (uint32_t c = 0; c < consumerCount; c++)
+    {
+        consumers.emplace_back([&, c]() {
+            auto subContext = BOCOM_JoinQueue("test_mpmc");
+            uint32_t msg[2] = {0, 0};
+            unsigned int msgLength = 0;
+            while (received.load() < producerCount * messageCount)
+            {
+                const auto ret = BOCOM_RetrieveQueue(subContext, msg, &msgLength);
+                if (ret == Success)
+                {
+                    seen[c * producerCount + msg[0]].push_back(msg[1]);
+                    received++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+            BOCOM_QuitQueue(subContext);
+        });
+    }
+    for (auto &t : producers)
+    {
+        t.join();
+    }
+    for (auto &t : consumers)
+    {
+        t.join();
+    }
+
+    for (uint32_t p = 0; p < producerCount; p++)
+    {
+        std::vector<uint32_t> all;
+        for (uint32_t c = 0; c < consumerCount; c++)
+        {
+            const auto &part = seen[c * producerCount + p];
+            // Each consumer sees a producer's messages in publish order.
+            ASSERT_TRUE(std::is_sorted(part.begin(), part.end()));
+            all.insert(all.end(), part.begin(), part.end());
+        }
+        std::sort(all.begin(), all.end());
+        ASSERT_EQ(all.size(), messageCount);
+        for (uint32_t i = 0; i < messageCount; i++)
+        {
+            ASSERT_EQ(all[i], i);
+        }
+    }
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, SeqLockObjectTest)
+{
+    constexpr auto frameWords = 4096;
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4 * frameWords * sizeof(uint64_t), 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"frame", frameWords * sizeof(uint64_t), SeqLock, 0, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+    auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(objCtx, nullptr);
+
+    std::atomic<bool> stop(false);
+    std::thread publisher([&]() {
+        // Every word of a frame carries the frame number, so torn copies are visible.
+        auto frame = std::vector<uint64_t>(frameWords);
+        for (uint64_t i = 1; !stop.load(); i++)
+        {
+            frame.assign(frameWords, i);
+            BOCOM_PublishObject(objCtx, frame.data(), frame.size() * sizeof(uint64_t), 1);
+        }
+    });
+
+    auto frame = std::vector<uint64_t>(frameWords);
+    uint64_t last = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        ASSERT_EQ(BOCOM_Retrieve(chnCtx, objInfo.objectName, frame.data(), frame.size() * sizeof(uint64_t), 1), Success);
+        ASSERT_EQ(std::count(frame.begin(), frame.end(), frame[0]), frameWords);
+        ASSERT_GE(frame[0], last);
+        last = frame[0];
+    }
+    stop = true;
+    publisher.join();
+
+    ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}
+
+TEST(BCOMTest, LatestObjectTest)
+{
+    constexpr auto frameWords = 4096;
+    constexpr auto readerCount = 2;
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", (readerCount + 3) * frameWords * sizeof(uint64_t), 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"frame", frameWords * sizeof(uint64_t), Latest, readerCount + 2, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+    auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(objCtx, nullptr);
+
+    // Readers always get the newest complete frame.
+    auto frame = std::vector<uint64_t>(frameWords);
+    for (uint64_t i = 1; i <= 5; i++)
+    {
+        frame.assign(frameWords, i);
+        ASSERT_EQ(BOCOM_PublishObject(objCtx, frame.data(), frame.size() * sizeof(uint64_t), 1), Success);
+        frame.assign(frameWords, 0);
+        ASSERT_EQ(BOCOM_RetrieveObject(objCtx, frame.data(), frame.size() * sizeof(uint64_t), 1), Success);
+        ASSERT_EQ(std::count(frame.begin(), frame.end(), i), frameWords);
+    }
+
+    std::atomic<bool> stop(false);
+    std::thread publisher([&]() {
+        auto frame = std::vector<uint64_t>(frameWords);
+        for (uint64_t i = 6; !stop.load(); i++)
+        {
+            frame.assign(frameWords, i);
+            BOCOM_PublishObject(objCtx, frame.data(), frame.size() * sizeof(uint64_t), 1);
+        }
+    });
+    std::vector<std::thread> readers;
+    std::atomic<int> torn(0);
+    for (int r = 0; r < readerCount; r++)
+    {
+        readers.emplace_back([&]() {
+            auto frame = std::vector<uint64_t>(frameWords);
+            uint64_t last = 0;
+            for (int i = 0; i < 2000; i++)
+            {
+                BOCOM_RetrieveObject(objCtx, frame.data(), frame.size() * sizeof(uint64_t), 1);
+                if (std::count(frame.begin(), frame.end(), frame[0]) != frameWords || frame[0] < last)
+                {
+                    torn++;
+                }
+                last = frame[0];
+            }
+        });
+    }
+    for (auto &t : readers)
+    {
+        t.join();
+    }
+    stop = true;
+    publisher.join();
+    ASSERT_EQ(torn.load(), 0);
+
+    st_OBJECT_INFO badInfo = {(char *)"bad", 64, Latest, 1, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &badInfo), Invalid);
+
+    ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}
+
+TEST(BCOMTest, LoanQueueSlotTest)
+{
+    constexpr auto maxElementSize = 128;
+    constexpr auto queueSize = 2;
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_loan", maxElementSize, queueSize, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_loan");
+        ASSERT_NE(subContext, nullptr);
+
+        auto value = std::vector<char>(maxElementSize, 0);
+        unsigned int valueLength = 0;
+        st_STATS_INFO stats;
+        const auto expectNext = [&](ErrorCode expected, char fill) {
+            ASSERT_EQ(BOCOM_RetrieveQueue(subContext, value.data(), &valueLength), expected);
+            ASSERT_EQ(valueLength, maxElementSize / 2u);
+            ASSERT_EQ(std::count(value.begin(), value.begin() + valueLength, fill), maxElementSize / 2);
+        };
+        const auto expectEmpty = [&](uint64_t dataLost) {
+            ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, value.data(), &valueLength, 0), Timeout);
+            ASSERT_EQ(BOCOM_GetQueueStats(subContext, &stats), Success);
+            ASSERT_EQ(stats.dataLost, dataLost);
+        };
+
+        void *slot = nullptr;
+        ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize + 1, &slot), Invalid);
+
+        // A given back loan publishes nothing and takes no room from the messages after it.
+        ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize, &slot), Success);
+        ASSERT_EQ(BOCOM_CommitQueueSlot(pubContext, slot, 0), Success);
+        for (char i = 1; i <= queueSize; i++)
+        {
+            ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize, &slot), Success);
+            std::memset(slot, i, maxElementSize / 2);
+            ASSERT_EQ(BOCOM_CommitQueueSlot(pubContext, slot, maxElementSize / 2), Success);
+        }
+        expectNext(Success, 1);
+        expectNext(Success, 2);
+        expectEmpty(0);
+
+        // Messages are built in place, also when they overwrite the oldest one.
+        for (char i = 3; i <= queueSize + 3; i++)
+        {
+            ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize, &slot), Success);
+            void *second = nullptr;
+            ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize, &second), Invalid);
+            std::memset(slot, i, maxElementSize / 2);
+            ASSERT_EQ(BOCOM_CommitQueueSlot(pubContext, slot, maxElementSize + 1), Invalid);
+            ASSERT_EQ(BOCOM_CommitQueueSlot(pubContext, slot, maxElementSize / 2), Success);
+        }
+        expectNext(DataLost, 4);
+        expectNext(Success, 5);
+        expectEmpty(1);
+
+        // On a full queue the loan drops the oldest message, giving it back does not restore it.
+        for (char i = 6; i < 6 + queueSize; i++)
+        {
+            std::memset(value.data(), i, maxElementSize / 2);
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, value.data(), maxElementSize / 2), Success);
+        }
+        ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize, &slot), Success);
+        ASSERT_EQ(BOCOM_CommitQueueSlot(pubContext, slot, 0), Success);
+        expectNext(DataLost, 7);
+        expectEmpty(2);
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, PeekQueueTest)
+{
+    constexpr auto queueSize = 2;
+    for (const auto queueMode : {Polling, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_peek", 64, queueSize, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_peek");
+        ASSERT_NE(subContext, nullptr);
+
+        const void *ptr = nullptr;
+        unsigned int valueLength = 0;
+        unsigned long long token = 0;
+        ASSERT_EQ(BOCOM_PeekQueue(subContext, &ptr, &valueLength, &token), NoData);
+
+        for (uint64_t i = 1; i <= queueSize; i++)
+        {
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+        }
+        ASSERT_EQ(BOCOM_PeekQueue(subContext, &ptr, &valueLength, &token), Success);
+        ASSERT_EQ(valueLength, sizeof(uint64_t));
+        ASSERT_EQ(*static_cast<const uint64_t *>(ptr), 1u);
+        const void *second = nullptr;
+        ASSERT_EQ(BOCOM_PeekQueue(subContext, &second, &valueLength, &token), Invalid);
+        ASSERT_EQ(BOCOM_ReleaseQueue(subContext, token + 1), Invalid);
+        ASSERT_EQ(BOCOM_ReleaseQueue(subContext, token), Success);
+
+        // Retrieve continues behind the peeked message.
+        uint64_t value = 0;
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+        ASSERT_EQ(value, 2u);
+
+        if (queueMode != Polling)
+        {
+            // A publisher wrapping around to the pinned slot waits for its release.
+            uint64_t next = 3;
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &next, sizeof(next)), Success);
+            ASSERT_EQ(BOCOM_PeekQueue(subContext, &ptr, &valueLength, &token), Success);
+            std::atomic<bool> published(false);
+            std::thread publisher([&]() {
+                for (uint64_t i = 4; i < 4 + 2 * queueSize; i++)
+                {
+                    BOCOM_PublishQueue(pubContext, &i, sizeof(i));
+                }
+                published = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ASSERT_EQ(*static_cast<const uint64_t *>(ptr), 3u);
+            ASSERT_EQ(BOCOM_ReleaseQueue(subContext, token), Success);
+            publisher.join();
+            ASSERT_TRUE(published.load());
+        }
+
+        // A message overwritten before it was read is reported by the next peek.
+        while (BOCOM_RetrieveQueue(subContext, &value, &valueLength) != NoData)
+        {
+        }
+        for (uint64_t i = 10; i < 10 + queueSize + 1; i++)
+        {
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+        }
+        ASSERT_EQ(BOCOM_PeekQueue(subContext, &ptr, &valueLength, &token), DataLost);
+        ASSERT_EQ(*static_cast<const uint64_t *>(ptr), 11u);
+        ASSERT_EQ(BOCOM_ReleaseQueue(subContext, token), Success);
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+        ASSERT_EQ(value, 12u);
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, AcquireObjectTest)
+{
+    struct Status
+    {
+        uint64_t header;
+        uint64_t counters[64];
+    };
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 16 * sizeof(Status), 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+
+    for (const auto objectMode : {RwLock, SeqLock, Latest})
+    {
+        st_OBJECT_INFO objInfo = {(char *)"status", sizeof(Status), objectMode, 0, 0};
+        ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+        auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+        ASSERT_NE(objCtx, nullptr);
+
+        Status status = {};
+        status.header = 1;
+        status.counters[10] = 42;
+        ASSERT_EQ(BOCOM_PublishObject(objCtx, &status, sizeof(status), 1), Success);
+
+        // Only one field is written in place, the others keep their value.
+        void *wptr = nullptr;
+        ASSERT_EQ(BOCOM_AcquireObjectWrite(objCtx, &wptr, 1), Success);
+        const void *rptr = nullptr;
+        ASSERT_EQ(BOCOM_AcquireObjectRead(objCtx, &rptr, 1), Invalid);
+        static_cast<Status *>(wptr)->header = 2;
+        ASSERT_EQ(BOCOM_ReleaseObject(objCtx), Success);
+        ASSERT_EQ(BOCOM_ReleaseObject(objCtx), Invalid);
+
+        ASSERT_EQ(BOCOM_AcquireObjectRead(objCtx, &rptr, 1), Success);
+        ASSERT_EQ(static_cast<const Status *>(rptr)->header, 2u);
+        ASSERT_EQ(static_cast<const Status *>(rptr)->counters[10], 42u);
+        ASSERT_EQ(BOCOM_ReleaseObject(objCtx), Success);
+
+        if (objectMode == SeqLock)
+        {
+            // A publish during an in-place read invalidates it.
+            ASSERT_EQ(BOCOM_AcquireObjectRead(objCtx, &rptr, 1), Success);
+            ASSERT_EQ(BOCOM_Publish(chnCtx, objInfo.objectName, &status, sizeof(status), 1), Success);
+            ASSERT_EQ(BOCOM_ReleaseObject(objCtx), DataLost);
+        }
+
+        ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+        ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+    }
+}
+
+TEST(BCOMTest, NonBlockingObjectTest)
+{
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+
+    for (const auto objectMode : {RwLock, SeqLock, Latest})
+    {
+        st_OBJECT_INFO objInfo = {(char *)"nonblocking", sizeof(int), objectMode, 0, 0};
+        ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+        auto writer = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+        auto reader = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+        ASSERT_NE(writer, nullptr);
+        ASSERT_NE(reader, nullptr);
+
+        int value = 7;
+        ASSERT_EQ(BOCOM_PublishObject(writer, &value, sizeof(value), 0), Success);
+
+        // While the object is written in place, calls with flags 0 return at once.
+        void *wptr = nullptr;
+        ASSERT_EQ(BOCOM_AcquireObjectWrite(writer, &wptr, 0), Success);
+        int out = 0;
+        ASSERT_EQ(BOCOM_PublishObject(reader, &value, sizeof(value), 0), Busy);
+        if (objectMode == Latest)
+        {
+            // Readers of the latest buffer never wait.
+            ASSERT_EQ(BOCOM_RetrieveObject(reader, &out, sizeof(out), 0), Success);
+            ASSERT_EQ(out, 7);
+        }
+        else
+        {
+            ASSERT_EQ(BOCOM_RetrieveObject(reader, &out, sizeof(out), 0), Busy);
+            const auto begin = std::chrono::steady_clock::now();
+            ASSERT_EQ(BOCOM_RetrieveObjectTimed(reader, &out, sizeof(out), 1, 20), Timeout);
+            ASSERT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(15));
+        }
+        *static_cast<int *>(wptr) = 8;
+        ASSERT_EQ(BOCOM_ReleaseObject(writer), Success);
+
+        ASSERT_EQ(BOCOM_RetrieveObject(reader, &out, sizeof(out), 0), Success);
+        ASSERT_EQ(out, 8);
+        ASSERT_EQ(BOCOM_RetrieveTimed(chnCtx, objInfo.objectName, &out, sizeof(out), 1, 20), Success);
+        // Nobody publishes, so waiting for the next publish times out.
+        ASSERT_EQ(BOCOM_RetrieveObjectTimed(reader, &out, sizeof(out), 2, 20), Timeout);
+
+        // A publish with flags 2 wakes the reader waiting for it, repeated in case it was not asleep yet.
+        std::atomic<bool> woken(false);
+        ErrorCode waited = ComError;
+        std::thread waiter([&]() {
+            waited = BOCOM_RetrieveObjectTimed(reader, &out, sizeof(out), 2, 2000);
+            woken = true;
+        });
+        value = 9;
+        while (!woken)
+        {
+            EXPECT_EQ(BOCOM_PublishObject(writer, &value, sizeof(value), 2), Success);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        waiter.join();
+        ASSERT_EQ(waited, Success);
+        ASSERT_EQ(out, 9);
+
+        ASSERT_EQ(BOCOM_CloseObject(reader), Success);
+        ASSERT_EQ(BOCOM_CloseObject(writer), Success);
+        ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+    }
+}
+
+TEST(BCOMTest, TimedRetrieveQueueTest)
+{
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_timed", sizeof(int), 4, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_timed");
+        ASSERT_NE(subContext, nullptr);
+
+        int out = 0;
+        unsigned int outLength = sizeof(out);
+        ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 0), Timeout);
+        const auto begin = std::chrono::steady_clock::now();
+        ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 20), Timeout);
+        ASSERT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(15));
+
+        // A message published while waiting is returned before the deadline.
+        std::thread publisher([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            int value = 5;
+            EXPECT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+        });
+        ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 5000), Success);
+        publisher.join();
+        ASSERT_EQ(out, 5);
+
+        // The waiter is woken by the publish in every mode, not by a retry timer.
+        constexpr auto rounds = 21;
+        std::vector<std::chrono::steady_clock::time_point> sent(rounds);
+        std::vector<std::chrono::steady_clock::duration> latency;
+        std::thread pacer([&] {
+            for (int i = 0; i < rounds; i++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                sent[i] = std::chrono::steady_clock::now();
+                EXPECT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+            }
+        });
+        for (int i = 0; i < rounds; i++)
+        {
+            ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 5000), Success);
+            latency.push_back(std::chrono::steady_clock::now() - sent[out]);
+        }
+        pacer.join();
+        std::nth_element(latency.begin(), latency.begin() + rounds / 2, latency.end());
+        ASSERT_LT(latency[rounds / 2], std::chrono::microseconds(500));
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+static bool Readable(int fd, int timeoutMs)
+{
+    pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, timeoutMs) == 1 && (pfd.revents & POLLIN);
+}
+
+TEST(BCOMTest, QueueFdTest)
+{
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_fd", sizeof(int), 4, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_fd");
+        ASSERT_NE(subContext, nullptr);
+        const int fd = BOCOM_GetQueueFd(subContext);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(BOCOM_GetQueueFd(subContext), fd);
+        ASSERT_FALSE(Readable(fd, 0));
+
+        // Retrieve until nothing is left, which clears the descriptor again.
+        auto drain = [&] {
+            int out = 0;
+            unsigned int outLength = sizeof(out);
+            int count = 0;
+            while (BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 0) == Success)
+            {
+                count++;
+            }
+            return count;
+        };
+        for (int round = 0; round < 3; round++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+            }
+            ASSERT_TRUE(Readable(fd, 1000));
+            ASSERT_EQ(drain(), 2);
+            ASSERT_FALSE(Readable(fd, 0));
+        }
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, ObjectFdTest)
+{
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"fd_object", sizeof(int), RwLock, 0, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+    auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(objCtx, nullptr);
+    const int fd = BOCOM_GetObjectFd(objCtx);
+    ASSERT_GE(fd, 0);
+
+    // Only publishes with flags 2 signal the descriptor.
+    int value = 1;
+    ASSERT_EQ(BOCOM_Publish(chnCtx, objInfo.objectName, &value, sizeof(value), 1), Success);
+    ASSERT_FALSE(Readable(fd, 0));
+    value = 2;
+    ASSERT_EQ(BOCOM_Publish(chnCtx, objInfo.objectName, &value, sizeof(value), 2), Success);
+    ASSERT_TRUE(Readable(fd, 1000));
+    int out = 0;
+    ASSERT_EQ(BOCOM_RetrieveObject(objCtx, &out, sizeof(out), 0), Success);
+    ASSERT_EQ(out, 2);
+    ASSERT_FALSE(Readable(fd, 0));
+
+    ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}
+
+TEST(BCOMTest, PublishQueueBatchTest)
+{
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_batch", sizeof(int), 8, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_batch");
+        ASSERT_NE(subContext, nullptr);
+
+        int values[6] = {1, 2, 3, 4, 5, 6};
+        iovec msgs[6];
+        for (int i = 0; i < 6; i++)
+        {
+            msgs[i] = {&values[i], sizeof(int)};
+        }
+        ASSERT_EQ(BOCOM_PublishQueueBatch(pubContext, msgs, 0), Invalid);
+        // An oversized message rejects the whole batch.
+        msgs[5].iov_len = 2 * sizeof(int);
+        ASSERT_EQ(BOCOM_PublishQueueBatch(pubContext, msgs, 6), Invalid);
+        msgs[5].iov_len = sizeof(int);
+        ASSERT_EQ(BOCOM_PublishQueueBatch(pubContext, msgs, 6), Success);
+
+        for (int i = 0; i < 6; i++)
+        {
+            int out = 0;
+            unsigned int outLength = sizeof(out);
+            ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 0), Success);
+            ASSERT_EQ(out, values[i]);
+        }
+        int out = 0;
+        unsigned int outLength = sizeof(out);
+        ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, &out, &outLength, 0), Timeout);
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, RetrieveQueueBatchTest)
+{
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_drain", sizeof(int), 4, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_drain");
+        ASSERT_NE(subContext, nullptr);
+
+        int out[3] = {};
+        void *bufs[3] = {&out[0], &out[1], &out[2]};
+        unsigned int lens[3] = {};
+        int got = 0;
+        unsigned int lost = 0;
+        if (queueMode != Notify)
+        {
+            ASSERT_EQ(BOCOM_RetrieveQueueBatch(subContext, bufs, lens, 3, &got, &lost), NoData);
+            ASSERT_EQ(got, 0);
+        }
+        const int first = 0;
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, &first, sizeof(first)), Success);
+        ASSERT_EQ(BOCOM_RetrieveQueueBatch(subContext, bufs, lens, 3, &got, &lost), Success);
+        ASSERT_EQ(got, 1);
+
+        // Six more messages into a queue of four: two are overwritten before they are read.
+        for (int i = 1; i <= 6; i++)
+        {
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+        }
+        ASSERT_EQ(BOCOM_RetrieveQueueBatch(subContext, bufs, lens, 3, &got, &lost), DataLost);
+        ASSERT_EQ(got, 3);
+        ASSERT_EQ(lost, 2u);
+        ASSERT_EQ(out[0], 3);
+        ASSERT_EQ(out[1], 4);
+        ASSERT_EQ(out[2], 5);
+        ASSERT_EQ(lens[2], sizeof(int));
+
+        ASSERT_EQ(BOCOM_RetrieveQueueBatch(subContext, bufs, lens, 3, &got, &lost), Success);
+        ASSERT_EQ(got, 1);
+        ASSERT_EQ(lost, 0u);
+        ASSERT_EQ(out[0], 6);
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, ScatterGatherTest)
+{
+    struct Header
+    {
+        int frameId;
+        int length;
+    };
+    Header header = {7, 12};
+    char payload[12] = "hello world";
+    const iovec fragments[2] = {{&header, sizeof(header)}, {payload, sizeof(payload)}};
+
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_iov", 64, 4, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_iov");
+        ASSERT_NE(subContext, nullptr);
+
+        ASSERT_EQ(BOCOM_PublishQueueV(pubContext, fragments, 2), Success);
+        ASSERT_EQ(BOCOM_PublishQueueV(pubContext, fragments, 2), Success);
+
+        // Scattered into separate buffers on the read side.
+        Header outHeader = {};
+        char outPayload[12] = {};
+        const iovec outFragments[2] = {{&outHeader, sizeof(outHeader)}, {outPayload, sizeof(outPayload)}};
+        unsigned int length = 0;
+        ASSERT_EQ(BOCOM_RetrieveQueueV(subContext, outFragments, 2, &length), Success);
+        ASSERT_EQ(length, sizeof(header) + sizeof(payload));
+        ASSERT_EQ(outHeader.frameId, 7);
+        ASSERT_STREQ(outPayload, payload);
+
+        // The fragments were gathered into one message.
+        char contiguous[64] = {};
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, contiguous, &length), Success);
+        ASSERT_EQ(length, sizeof(header) + sizeof(payload));
+        ASSERT_EQ(std::memcmp(contiguous, &header, sizeof(header)), 0);
+        ASSERT_STREQ(contiguous + sizeof(header), payload);
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    for (const auto objectMode : {RwLock, SeqLock, Latest})
+    {
+        st_OBJECT_INFO objInfo = {(char *)"frame", sizeof(header) + sizeof(payload), objectMode, 0, 0};
+        ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+        auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+        ASSERT_NE(objCtx, nullptr);
+
+        ASSERT_EQ(BOCOM_PublishObjectV(objCtx, fragments, 2, 1), Success);
+        Header outHeader = {};
+        char outPayload[12] = {};
+        const iovec outFragments[2] = {{&outHeader, sizeof(outHeader)}, {outPayload, sizeof(outPayload)}};
+        ASSERT_EQ(BOCOM_RetrieveObjectV(objCtx, outFragments, 2, 1), Success);
+        ASSERT_EQ(outHeader.length, 12);
+        ASSERT_STREQ(outPayload, payload);
+
+        // More than the object holds is rejected.
+        const iovec tooLong[3] = {fragments[0], fragments[1], fragments[0]};
+        ASSERT_EQ(BOCOM_PublishObjectV(objCtx, tooLong, 3, 1), Invalid);
+
+        ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+        ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+    }
+}
+
+TEST(BCOMTest, DeepQueueTest)
+{
+    constexpr auto maxElementSize = 8;
+    constexpr auto queueSize = 1000;
+    for (const auto queueMode : {Polling, Notify})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_deep", maxElementSize, queueSize, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_deep");
+        ASSERT_NE(subContext, nullptr);
+
+        // The queue segment holds every slot, a deep queue of small messages fills and wraps without running out.
+        for (uint32_t i = 0; i < 3 * queueSize; i++)
+        {
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &i, sizeof(i)), Success);
+        }
+
+        uint32_t value = 0;
+        unsigned int valueLength = 0;
+        for (uint32_t i = 2 * queueSize; i < 3 * queueSize; i++)
+        {
+            ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), Success);
+            ASSERT_EQ(valueLength, sizeof(value));
+            ASSERT_EQ(value, i);
+        }
+        // Notify consumers would sleep here.
+        if (queueMode == Polling)
+        {
+            ASSERT_EQ(BOCOM_RetrieveQueue(subContext, &value, &valueLength), NoData);
+        }
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, ByteRingQueueTest)
+{
+    constexpr auto maxElementSize = 64 * 1024;
+    constexpr auto queueSize = 1000;
+    constexpr auto queueBytes = 128 * 1024;
+    st_QUEUE_INFO badInfo = {(char *)"test_bytes", maxElementSize, queueSize, Spsc, queueBytes, 0, 0, 0};
+    ASSERT_EQ(BOCOM_CreateQueue(&badInfo), nullptr);
+    badInfo = {(char *)"test_bytes", maxElementSize, queueSize, Polling, maxElementSize / 2, 0, 0, 0};
+    ASSERT_EQ(BOCOM_CreateQueue(&badInfo), nullptr);
+
+    st_QUEUE_INFO queueInfo = {(char *)"test_bytes", maxElementSize, queueSize, Polling, queueBytes, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_bytes");
+    ASSERT_NE(subContext, nullptr);
+
+    void *slot = nullptr;
+    ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, 16, &slot), Invalid);
+
+    auto value = std::vector<char>(maxElementSize, 0);
+    unsigned int valueLength = 0;
+
+    // Small messages only take their own size.
+    for (char i = 1; i <= 3; i++)
+    {
+        const auto small = std::vector<char>(100, i);
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, small.data(), small.size()), Success);
+    }
+    for (char i = 1; i <= 3; i++)
+    {
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, value.data(), &valueLength), Success);
+        ASSERT_EQ(valueLength, 100u);
+        ASSERT_EQ(std::count(value.begin(), value.begin() + valueLength, i), 100);
+    }
+
+    // The third large message wraps around and needs the room of everything before the second one.
+    for (char i = 4; i <= 6; i++)
+    {
+        const auto large = std::vector<char>(60000, i);
+        ASSERT_EQ(BOCOM_PublishQueue(pubContext, large.data(), large.size()), Success);
+    }
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, value.data(), &valueLength), DataLost);
+    ASSERT_EQ(valueLength, 60000u);
+    ASSERT_EQ(std::count(value.begin(), value.begin() + valueLength, 5), 60000);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, value.data(), &valueLength), Success);
+    ASSERT_EQ(std::count(value.begin(), value.begin() + valueLength, 6), 60000);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, value.data(), &valueLength), NoData);
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+}
+
+TEST(BCOMTest, MemoryFlagsTest)
+{
+    constexpr auto maxElementSize = 4096;
+    constexpr auto queueSize = 64;
+    st_QUEUE_INFO queueInfo = {(char *)"test_memory", maxElementSize, queueSize, Polling, 0, MemPrefault | MemHugePages, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto subContext = BOCOM_JoinQueue("test_memory");
+    ASSERT_NE(subContext, nullptr);
+
+    // Every buffer was faulted in at creation, before anything was published into it.
+    void *slot = nullptr;
+    ASSERT_EQ(BOCOM_LoanQueueSlot(pubContext, maxElementSize, &slot), Success);
+    const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const auto first = reinterpret_cast<uintptr_t>(slot) & ~(pageSize - 1);
+    auto resident = std::vector<unsigned char>(queueSize * maxElementSize / pageSize, 0);
+    ASSERT_EQ(mincore(reinterpret_cast<void *>(first), resident.size() * pageSize, resident.data()), 0);
+    ASSERT_EQ(std::count_if(resident.begin(), resident.end(), [](unsigned char page) { return page & 1; }),
+              static_cast<long>(resident.size()));
+    ASSERT_EQ(BOCOM_CommitQueueSlot(pubContext, slot, 0), Success);
+
+    const int value = 7;
+    int received = 0;
+    unsigned int valueLength = 0;
+    ASSERT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+    std::vector<char> out(maxElementSize);
+    ASSERT_EQ(BOCOM_RetrieveQueue(subContext, out.data(), &valueLength), Success);
+    std::memcpy(&received, out.data(), sizeof(received));
+    ASSERT_EQ(received, value);
+
+    ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+
+    // Locking may be refused by RLIMIT_MEMLOCK, the channel is usable either way.
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, MemLock, 0, 0};
+    auto chnContext = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnContext, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"locked", sizeof(int), RwLock, 0, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnContext, &objInfo), Success);
+    ASSERT_NE(BOCOM_JoinChannel((char *)"test_channel"), nullptr);
+    ASSERT_EQ(BOCOM_DestroyObject(chnContext, &objInfo), Success);
+}
+
+TEST(BCOMTest, NumaNodeTest)
+{
+    // Every machine has a node 0, a joining process learns where the slots live.
+    for (const auto memoryFlags : {0, static_cast<int>(MemNumaBind), static_cast<int>(MemNumaInterleave)})
+    {
+        for (const auto queueMode : {Polling, Spsc})
+        {
+            st_QUEUE_INFO queueInfo = {(char *)"test_numa", 64, 4, queueMode, 0, memoryFlags, 0, 0};
+            auto pubContext = BOCOM_CreateQueue(&queueInfo);
+            ASSERT_NE(pubContext, nullptr);
+            auto subContext = BOCOM_JoinQueue("test_numa");
+            ASSERT_NE(subContext, nullptr);
+            ASSERT_GE(BOCOM_GetQueueNode(subContext), 0);
+            if (memoryFlags == MemNumaBind)
+            {
+                ASSERT_EQ(BOCOM_GetQueueNode(subContext), 0);
+            }
+            ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+            ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+        }
+    }
+    ASSERT_EQ(BOCOM_GetQueueNode(nullptr), -1);
+
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, MemNumaBind, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"numa_object", sizeof(int), RwLock, 0, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+    auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(objCtx, nullptr);
+    ASSERT_EQ(BOCOM_GetObjectNode(objCtx), 0);
+    ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}
+
+TEST(BCOMTest, QueueLayoutTest)
+{
+    // Loaned buffers start on a cache line in every process, the ring payloads on 16 bytes.
+    for (const auto queueMode : {Polling, Notify, Spsc, Mpmc})
+    {
+        st_QUEUE_INFO queueInfo = {(char *)"test_layout", 100, 8, queueMode, 0, 0, 0, 0};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_layout");
+        ASSERT_NE(subContext, nullptr);
+        const uintptr_t alignment = (queueMode == Spsc || queueMode == Mpmc) ? 16 : 64;
+        for (auto context : {pubContext, subContext})
+        {
+            for (auto i = 0; i < 3; i++)
+            {
+                void *slot = nullptr;
+                ASSERT_EQ(BOCOM_LoanQueueSlot(context, 100, &slot), Success);
+                ASSERT_EQ(reinterpret_cast<uintptr_t>(slot) % alignment, 0u);
+                ASSERT_EQ(BOCOM_CommitQueueSlot(context, slot, 1), Success);
+            }
+        }
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+}
+
+TEST(BCOMTest, QueueStatsTest)
+{
+    const std::vector<std::pair<QueueMode, int>> cases = {{Polling, 0}, {Polling, StatsLockTimes}, {Spsc, StatsLockTimes}};
+    for (const auto &c : cases)
+    {
+        const auto queueMode = c.first;
+        const auto statsFlags = c.second;
+        st_QUEUE_INFO queueInfo = {(char *)"test_stats", 64, 4, queueMode, 0, 0, 0, statsFlags};
+        auto pubContext = BOCOM_CreateQueue(&queueInfo);
+        ASSERT_NE(pubContext, nullptr);
+        auto subContext = BOCOM_JoinQueue("test_stats");
+        ASSERT_NE(subContext, nullptr);
+
+        // Six messages overrun a queue of four, the consumer sees one DataLost.
+        int value = 0;
+        for (value = 0; value < 6; value++)
+        {
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+        }
+        st_STATS_INFO stats;
+        ASSERT_EQ(BOCOM_GetQueueStats(subContext, &stats), Success);
+        ASSERT_EQ(stats.publishes, 6u);
+        ASSERT_EQ(stats.depth, 4u);
+
+        // Only the first retrieve has nothing to compare against, the four publishes after it overrun it.
+        std::vector<char> out(64);
+        unsigned int outLength = 0;
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, out.data(), &outLength), Success);
+        for (auto i = 0; i < 4; i++)
+        {
+            ASSERT_EQ(BOCOM_PublishQueue(pubContext, &value, sizeof(value)), Success);
+        }
+        ASSERT_EQ(BOCOM_RetrieveQueue(subContext, out.data(), &outLength), DataLost);
+        while (BOCOM_RetrieveQueue(subContext, out.data(), &outLength) != NoData)
+        {
+        }
+        ASSERT_EQ(BOCOM_RetrieveQueueTimed(subContext, out.data(), &outLength, 1), Timeout);
+
+        // Both sides read the same counters.
+        ASSERT_EQ(BOCOM_GetQueueStats(pubContext, &stats), Success);
+        ASSERT_EQ(stats.publishes, 10u);
+        ASSERT_EQ(stats.retrieves, 5u);
+        ASSERT_EQ(stats.dataLost, 1u);
+        ASSERT_EQ(stats.noData, 2u);
+        // Polling consumers leave the messages to the others, the ring consumer takes them.
+        ASSERT_EQ(stats.depth, (queueMode == Polling) ? 4u : 0u);
+        unsigned long long waits = 0;
+        unsigned long long holds = 0;
+        for (auto i = 0; i < BOCOM_STATS_BUCKETS; i++)
+        {
+            waits += stats.lockWait[i];
+            holds += stats.lockHold[i];
+        }
+        // Every publish and retrieve took the lock at least once, the ring modes take none.
+        // The lock times are only kept when asked for.
+        if (queueMode == Polling && statsFlags == StatsLockTimes)
+        {
+            ASSERT_GE(waits, 16u);
+        }
+        else
+        {
+            ASSERT_EQ(waits, 0u);
+        }
+        ASSERT_EQ(holds, waits);
+
+        ASSERT_EQ(BOCOM_QuitQueue(subContext), Success);
+        ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+    }
+    st_STATS_INFO stats;
+    ASSERT_EQ(BOCOM_GetQueueStats(nullptr, &stats), ComError);
+}
+
+TEST(BCOMTest, ObjectStatsTest)
+{
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"stats_object", sizeof(int), RwLock, 0, StatsLockTimes};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+    auto objCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(objCtx, nullptr);
+
+    int value = 5;
+    ASSERT_EQ(BOCOM_PublishObject(objCtx, &value, sizeof(value), 1), Success);
+    ASSERT_EQ(BOCOM_Publish(chnCtx, objInfo.objectName, &value, sizeof(value), 1), Success);
+    ASSERT_EQ(BOCOM_RetrieveObject(objCtx, &value, sizeof(value), 1), Success);
+
+    // A writer in place makes the non-blocking calls busy, its hold shows in the histogram.
+    void *ptr = nullptr;
+    ASSERT_EQ(BOCOM_AcquireObjectWrite(objCtx, &ptr, 1), Success);
+    auto readCtx = BOCOM_OpenObject(chnCtx, objInfo.objectName);
+    ASSERT_NE(readCtx, nullptr);
+    ASSERT_EQ(BOCOM_RetrieveObject(readCtx, &value, sizeof(value), 0), Busy);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ASSERT_EQ(BOCOM_ReleaseObject(objCtx), Success);
+
+    st_STATS_INFO stats;
+    ASSERT_EQ(BOCOM_GetObjectStats(readCtx, &stats), Success);
+    ASSERT_EQ(stats.publishes, 3u);
+    ASSERT_EQ(stats.retrieves, 1u);
+    ASSERT_EQ(stats.busy, 1u);
+    ASSERT_EQ(stats.depth, 0u);
+    ASSERT_GE(stats.lockHoldNs, 2000000u);
+    // 2ms falls in bucket 15, from 32ns << 15 to 64ns << 15.
+    unsigned long long longHolds = 0;
+    for (auto i = 15; i < BOCOM_STATS_BUCKETS; i++)
+    {
+        longHolds += stats.lockHold[i];
+    }
+    ASSERT_EQ(longHolds, 1u);
+
+    ASSERT_EQ(BOCOM_CloseObject(readCtx), Success);
+    ASSERT_EQ(BOCOM_CloseObject(objCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}
+
+TEST(BCOMTest, InspectTest)
+{
+    ASSERT_EQ(BOCOM_AttachInspect("test_missing"), nullptr);
+
+    st_QUEUE_INFO queueInfo = {(char *)"test_inspect", 64, 8, Polling, 0, 0, 0, 0};
+    auto pubContext = BOCOM_CreateQueue(&queueInfo);
+    ASSERT_NE(pubContext, nullptr);
+    auto joinedPublisher = BOCOM_JoinQueue("test_inspect");
+    ASSERT_NE(joinedPublisher, nullptr);
+    auto fastContext = BOCOM_JoinQueue("test_inspect");
+    ASSERT_NE(fastContext, nullptr);
+    auto slowContext = BOCOM_JoinQueue("test_inspect");
+    ASSERT_NE(slowContext, nullptr);
+
+    int value = 0;
+    for (value = 0; value < 5; value++)
+    {
+        ASSERT_EQ(BOCOM_PublishQueue(joinedPublisher, &value, sizeof(value)), Success);
+    }
+    std::vector<char> out(64);
+    unsigned int outLength = 0;
+    for (auto i = 0; i < 4; i++)
+    {
+        ASSERT_EQ(BOCOM_RetrieveQueue(fastContext, out.data(), &outLength), Success);
+    }
+    ASSERT_EQ(BOCOM_RetrieveQueue(slowContext, out.data(), &outLength), Success);
+
+    auto inspCtx = BOCOM_AttachInspect("test_inspect");
+    ASSERT_NE(inspCtx, nullptr);
+    st_SEGMENT_INFO info;
+    st_ENTRY_INFO entries[4];
+    int count = 0;
+    ASSERT_EQ(BOCOM_InspectSegment(inspCtx, &info, entries, 4, &count), Success);
+    ASSERT_EQ(info.isQueue, 1);
+    ASSERT_EQ(count, 1);
+    ASSERT_GT(info.size, info.freeMemory);
+    ASSERT_STREQ(entries[0].name, "test_inspect");
+    ASSERT_EQ(entries[0].mode, Polling);
+    ASSERT_EQ(entries[0].capacity, 8);
+    ASSERT_EQ(entries[0].stats.publishes, 5u);
+    ASSERT_EQ(entries[0].stats.retrieves, 5u);
+    ASSERT_EQ(entries[0].stats.depth, 5u);
+
+    // The consumers are listed in the order of their first retrieve, each with its own lag.
+    // A process that joined only to publish is not one of them.
+    st_CONSUMER_INFO consumers[4];
+    ASSERT_EQ(BOCOM_InspectConsumers(inspCtx, consumers, 4, &count), Success);
+    ASSERT_EQ(count, 2);
+    ASSERT_EQ(consumers[0].pid, getpid());
+    ASSERT_EQ(consumers[0].lag, 1u);
+    ASSERT_EQ(consumers[1].lag, 4u);
+
+    ASSERT_EQ(BOCOM_QuitQueue(slowContext), Success);
+    ASSERT_EQ(BOCOM_InspectConsumers(inspCtx, consumers, 4, &count), Success);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(BOCOM_DetachInspect(inspCtx), Success);
+    ASSERT_EQ(BOCOM_QuitQueue(fastContext), Success);
+    ASSERT_EQ(BOCOM_QuitQueue(joinedPublisher), Success);
+    ASSERT_EQ(BOCOM_DestroyQueue(pubContext), Success);
+
+    // A channel lists its objects.
+    st_CHANNAL_INFO chnInfo = {(char *)"test_channel", 4096, 0, 0, 0};
+    auto chnCtx = BOCOM_CreateChannel(&chnInfo);
+    ASSERT_NE(chnCtx, nullptr);
+    st_OBJECT_INFO objInfo = {(char *)"inspect_object", 32, Latest, 4, 0};
+    ASSERT_EQ(BOCOM_ConstructObject(chnCtx, &objInfo), Success);
+    ASSERT_EQ(BOCOM_Publish(chnCtx, objInfo.objectName, &value, sizeof(value), 1), Success);
+
+    inspCtx = BOCOM_AttachInspect("test_channel");
+    ASSERT_NE(inspCtx, nullptr);
+    ASSERT_EQ(BOCOM_InspectSegment(inspCtx, &info, entries, 4, &count), Success);
+    ASSERT_EQ(info.isQueue, 0);
+    ASSERT_EQ(info.entries, 1);
+    ASSERT_EQ(count, 1);
+    ASSERT_STREQ(entries[0].name, "inspect_object");
+    ASSERT_EQ(entries[0].elementSize, 32);
+    ASSERT_EQ(entries[0].mode, Latest);
+    ASSERT_EQ(entries[0].capacity, 4);
+    ASSERT_EQ(entries[0].stats.publishes, 1u);
+    ASSERT_EQ(BOCOM_InspectConsumers(inspCtx, consumers, 4, &count), Invalid);
+    ASSERT_EQ(BOCOM_DetachInspect(inspCtx), Success);
+    ASSERT_EQ(BOCOM_DestroyObject(chnCtx, &objInfo), Success);
+}